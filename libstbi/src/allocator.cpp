@@ -0,0 +1,318 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    void* defaultMalloc(size_t size, void*) {
+        return malloc(size);
+    }
+
+    void defaultFree(void* p, void*) {
+        free(p);
+    }
+
+    struct Host {
+        HostMalloc malloc;
+        HostFree free;
+        void* user;
+    };
+
+    const Host defaultHost = {&defaultMalloc, &defaultFree, nullptr};
+
+    // Replaced hosts are leaked rather than deleted, because other threads may still be allocating from them. Hosts are
+    // replaced rarely, if ever.
+    std::atomic<const Host*> host{&defaultHost};
+
+    std::atomic<int64_t> arenaCapacity{16 * 1024 * 1024};
+
+    // Statistics are counted per arena, such that allocations do not contend for shared cache lines. Only changes of the
+    // live bytes that add up to at least this much are applied to the shared count right away, which the peak is tracked
+    // from.
+    const int64_t LIVE_BYTES_GRANULARITY = 64 * 1024;
+
+    std::atomic<int64_t> nLiveBytes{0};
+    std::atomic<int64_t> nPeakLiveBytes{0};
+
+    // Precedes every block. Its size keeps the payload aligned like memory from malloc. Blocks are returned to the host that
+    // they were obtained from, even if it was replaced since.
+    struct alignas(16) Header {
+        size_t capacity;
+        size_t bin;
+        HostFree hostFree;
+        void* hostUser;
+    };
+
+    // Freed blocks are linked through their payload.
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const size_t MIN_CAPACITY = 64;
+    const size_t MAX_CAPACITY = SIZE_MAX / 8;
+
+    // Bin 0 holds blocks of MIN_CAPACITY. Beyond that, each power-of-two interval (2^k, 2^(k+1)] is split into 4 bins.
+    const size_t N_BINS = 1 + 4 * (sizeof(size_t) * 8);
+
+    size_t sizeClass(size_t size, size_t* bin) {
+        if (size <= MIN_CAPACITY) {
+            *bin = 0;
+            return MIN_CAPACITY;
+        }
+
+        int k = 6;
+        while (((size_t)1 << (k + 1)) < size) {
+            ++k;
+        }
+
+        size_t step = (size_t)1 << (k - 2);
+        size_t nSteps = (size + step - 1) / step;
+        *bin = 1 + 4 * (k - 6) + (nSteps - 5);
+        return nSteps * step;
+    }
+
+    // Only ever written by the thread that owns the arena, but read by getAllocatorStats on any thread.
+    struct Counter {
+        std::atomic<int64_t> value{0};
+
+        void add(int64_t n) {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        int64_t get() const {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Arena;
+
+    // Arenas of live threads, through which getAllocatorStats sums the statistics, and the statistics of arenas whose
+    // threads exited.
+    std::mutex arenasMutex;
+    Arena* arenas = nullptr;
+    int64_t nExitedAllocations = 0;
+    int64_t nExitedArenaHits = 0;
+
+    struct Arena {
+        FreeBlock* bins[N_BINS] = {};
+
+        Counter nAllocations;
+        Counter nArenaHits;
+        Counter nRetainedBytes;
+        // Changes of the live bytes that were not yet applied to nLiveBytes.
+        Counter nPendingLiveBytes;
+
+        Arena* prev = nullptr;
+        Arena* next = nullptr;
+
+        Arena() {
+            std::lock_guard<std::mutex> lock{arenasMutex};
+            next = arenas;
+            if (next) {
+                next->prev = this;
+            }
+
+            arenas = this;
+        }
+
+        ~Arena() {
+            for (FreeBlock*& head : bins) {
+                while (head) {
+                    FreeBlock* block = head;
+                    head = head->next;
+
+                    Header* header = (Header*)block - 1;
+                    header->hostFree(header, header->hostUser);
+                }
+            }
+
+            nLiveBytes.fetch_add(nPendingLiveBytes.get(), std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock{arenasMutex};
+            nExitedAllocations += nAllocations.get();
+            nExitedArenaHits += nArenaHits.get();
+
+            if (prev) {
+                prev->next = next;
+            } else {
+                arenas = next;
+            }
+
+            if (next) {
+                next->prev = prev;
+            }
+        }
+
+        void addLiveBytes(int64_t n) {
+            int64_t pending = nPendingLiveBytes.get() + n;
+            if (pending > -LIVE_BYTES_GRANULARITY && pending < LIVE_BYTES_GRANULARITY) {
+                nPendingLiveBytes.value.store(pending, std::memory_order_relaxed);
+                return;
+            }
+
+            nPendingLiveBytes.value.store(0, std::memory_order_relaxed);
+            int64_t live = nLiveBytes.fetch_add(pending, std::memory_order_relaxed) + pending;
+            int64_t peak = nPeakLiveBytes.load(std::memory_order_relaxed);
+            while (live > peak && !nPeakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        }
+    };
+
+    // Threads that exit, such as those of parallelFor, take their arena with them.
+    thread_local Arena arena;
+
+    struct TargetBuffer {
+        unsigned char* data = nullptr;
+        size_t size = 0;
+        bool inUse = false;
+    };
+
+    thread_local TargetBuffer targetBuffer;
+
+    void* allocBlock(size_t size) {
+        if (size > MAX_CAPACITY) {
+            return nullptr;
+        }
+
+        arena.nAllocations.add(1);
+
+        size_t bin;
+        size_t capacity = sizeClass(size, &bin);
+
+        Header* header;
+        if (arena.bins[bin]) {
+            FreeBlock* block = arena.bins[bin];
+            arena.bins[bin] = block->next;
+            arena.nRetainedBytes.add(-(int64_t)capacity);
+            arena.nArenaHits.add(1);
+
+            header = (Header*)block - 1;
+        } else {
+            const Host* h = host.load(std::memory_order_acquire);
+            header = (Header*)h->malloc(sizeof(Header) + capacity, h->user);
+            if (!header) {
+                return nullptr;
+            }
+
+            header->capacity = capacity;
+            header->bin = bin;
+            header->hostFree = h->free;
+            header->hostUser = h->user;
+        }
+
+        arena.addLiveBytes((int64_t)capacity);
+        return header + 1;
+    }
+
+    void freeBlock(void* p) {
+        Header* header = (Header*)p - 1;
+        arena.addLiveBytes(-(int64_t)header->capacity);
+
+        if (arena.nRetainedBytes.get() + (int64_t)header->capacity > arenaCapacity.load(std::memory_order_relaxed)) {
+            header->hostFree(header, header->hostUser);
+            return;
+        }
+
+        FreeBlock* block = (FreeBlock*)p;
+        block->next = arena.bins[header->bin];
+        arena.bins[header->bin] = block;
+        arena.nRetainedBytes.add((int64_t)header->capacity);
+    }
+}
+
+void* stbiMalloc(size_t size) {
+    if (targetBuffer.data && !targetBuffer.inUse && size == targetBuffer.size) {
+        targetBuffer.inUse = true;
+        return targetBuffer.data;
+    }
+
+    return allocBlock(size);
+}
+
+void stbiFree(void* p) {
+    if (!p) {
+        return;
+    }
+
+    if (p == targetBuffer.data) {
+        targetBuffer.inUse = false;
+        return;
+    }
+
+    freeBlock(p);
+}
+
+void* stbiRealloc(void* p, size_t size) {
+    if (!p) {
+        return stbiMalloc(size);
+    }
+
+    size_t capacity;
+    if (p == targetBuffer.data) {
+        // The target buffer can not grow, so it has to be moved into a regular allocation.
+        capacity = targetBuffer.size;
+    } else {
+        capacity = ((Header*)p - 1)->capacity;
+        if (size <= capacity) {
+            return p;
+        }
+    }
+
+    void* result = allocBlock(size);
+    if (result) {
+        memcpy(result, p, size < capacity ? size : capacity);
+        stbiFree(p);
+    }
+
+    return result;
+}
+
+void setTargetBuffer(void* data, size_t size) {
+    targetBuffer.data = (unsigned char*)data;
+    targetBuffer.size = size;
+    targetBuffer.inUse = false;
+}
+
+void clearTargetBuffer() {
+    targetBuffer = TargetBuffer{};
+}
+
+void setHostAllocator(HostMalloc malloc, HostFree free, void* user) {
+    if (!malloc || !free) {
+        host.store(&defaultHost, std::memory_order_release);
+        return;
+    }
+
+    host.store(new Host{malloc, free, user}, std::memory_order_release);
+}
+
+void setArenaCapacity(int64_t nBytes) {
+    arenaCapacity = nBytes < 0 ? 0 : nBytes;
+}
+
+void getAllocatorStats(AllocatorStats* stats) {
+    std::lock_guard<std::mutex> lock{arenasMutex};
+    stats->nAllocations = nExitedAllocations;
+    stats->nArenaHits = nExitedArenaHits;
+    stats->nLiveBytes = nLiveBytes.load(std::memory_order_relaxed);
+    stats->nRetainedBytes = 0;
+
+    for (Arena* a = arenas; a; a = a->next) {
+        stats->nAllocations += a->nAllocations.get();
+        stats->nArenaHits += a->nArenaHits.get();
+        stats->nLiveBytes += a->nPendingLiveBytes.get();
+        stats->nRetainedBytes += a->nRetainedBytes.get();
+    }
+
+    stats->nPeakLiveBytes = std::max(nPeakLiveBytes.load(std::memory_order_relaxed), stats->nLiveBytes);
+}
+
+void resetPeakLiveBytes() {
+    nPeakLiveBytes.store(nLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
@@ -0,0 +1,51 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Functions through which the allocator obtains memory from, and returns memory to, its host. By default, these are
+// malloc and free.
+using HostMalloc = void* (*)(size_t size, void* user);
+using HostFree = void (*)(void* p, void* user);
+
+// Aggregated over all threads. Mirrored by StbiAllocatorStats in stbi-sharp.cs.
+struct AllocatorStats {
+    int64_t nAllocations;
+    // Allocations that were served from the arena of the allocating thread rather than by the host.
+    int64_t nArenaHits;
+    // Bytes that are currently allocated, either by decoders or by loaded images that have not been freed yet.
+    int64_t nLiveBytes;
+    // Every thread applies changes of its live bytes to the peak in steps of 64 KiB, so the peak may miss short spikes.
+    int64_t nPeakLiveBytes;
+    // Freed bytes that arenas hold on to for reuse.
+    int64_t nRetainedBytes;
+};
+
+// stb_image's STBI_MALLOC, STBI_REALLOC, and STBI_FREE. Every thread has an arena of freed blocks in size classes that are
+// at most 25% larger than the requested size. Decoders allocate and free the same scratch buffers over and over, so the
+// arena serves most of their allocations without involving the host allocator.
+void* stbiMalloc(size_t size);
+void* stbiRealloc(void* p, size_t size);
+void stbiFree(void* p);
+
+// While a target buffer is set on the calling thread, the first allocation of exactly its size is served from it, such that
+// stb_image writes its output straight into the buffer rather than into a temporary that has to be copied afterwards.
+void setTargetBuffer(void* data, size_t size);
+void clearTargetBuffer();
+
+// Subsequent allocations obtain memory from the new host. Memory that was obtained before, including blocks that arenas hold
+// on to, is still returned to the host that it was obtained from, so both hosts must remain usable until it is freed.
+void setHostAllocator(HostMalloc hostMalloc, HostFree hostFree, void* user);
+
+// Sets the maximum number of freed bytes that each thread's arena holds on to. Blocks beyond that are returned to the host.
+// An arena lives as long as its thread. The threads of parallelPool, on which LoadBatch and InfoBatch run, and those of the
+// async pool persist across calls, so their arenas are reused by subsequent loads.
+void setArenaCapacity(int64_t nBytes);
+
+void getAllocatorStats(AllocatorStats* stats);
+
+// Lowers the peak number of live bytes to the current number, such that a new high-water mark can be measured.
+void resetPeakLiveBytes();
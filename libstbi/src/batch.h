@@ -0,0 +1,53 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <inttypes.h>
+
+// The layouts of LoadBatch and InfoBatch, which are shared by stbi.cpp and stbi_bench.
+
+// Error codes with which loads fail. Mirrored by StbiError in stbi-sharp.cs.
+enum Error : int {
+    ErrorOk = 0,
+    ErrorInvalidArgument = 1,
+    ErrorUnknownFormat = 2,
+    ErrorCorrupt = 3,
+    ErrorUnsupported = 4,
+    ErrorOutOfMemory = 5,
+    ErrorTooLarge = 6,
+    ErrorIo = 7,
+    ErrorCancelled = 8,
+};
+
+// Describes one image of a LoadBatch call. The fields up to and including dstLen are inputs; the remaining fields are outputs.
+struct BatchItem {
+    const unsigned char* data;
+    int64_t len;
+    int nDesiredChannels;
+    // When null, a buffer is allocated for the image and stored here. It has to be released by Free.
+    unsigned char* dst;
+    // The number of bytes that dst is long. Images that do not fit fail with ErrorInvalidArgument. Ignored when dst is null.
+    int64_t dstLen;
+
+    int width;
+    int height;
+    int nChannels;
+    Error status;
+    const char* failureReason;
+};
+
+// Describes one image of an InfoBatch call. The fields up to and including len are inputs; the remaining fields are outputs.
+struct InfoItem {
+    const unsigned char* data;
+    int64_t len;
+
+    int width;
+    int height;
+    int nChannels;
+    // 8 or 16 for unsigned integer channels, or 32 for HDR images, whose channels are natively float.
+    int bitsPerChannel;
+    int isHdr;
+    Error status;
+    const char* failureReason;
+};
@@ -0,0 +1,343 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+// Measures the decoding throughput of libstbi's exports on a corpus of encoded images. Usage:
+//
+//     stbi_bench [--threads N] [--iterations K] [--channels C] <image files...>
+//
+// Images are grouped by format. For each export, each format, and each thread count from 1 up to N (doubling), the
+// corpus is decoded K times, after which images/s, MB/s of encoded input, and the p50/p99 latency of a single call are
+// reported. The peak resident set size of the process is reported at the end.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include "batch.h"
+
+extern "C" {
+    bool InfoFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels);
+    bool LoadFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, unsigned char* dst);
+    unsigned char* LoadFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels);
+    unsigned short* Load16FromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels);
+    float* LoadFFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels);
+    void LoadBatch(BatchItem* items, int64_t nItems, int nThreads);
+    void Free(unsigned char* pixels);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Image {
+        std::string path;
+        std::vector<unsigned char> data;
+        // Size of the decoded image with the requested number of channels at 8 bits per channel.
+        size_t decodedSize;
+    };
+
+    struct Group {
+        std::string format;
+        std::vector<Image> images;
+        size_t totalBytes = 0;
+    };
+
+    bool readFile(const char* path, std::vector<unsigned char>& data) {
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            return false;
+        }
+
+        unsigned char buffer[1 << 16];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    // Identifies the format from the file signature. JPEGs are further split into baseline and progressive, because
+    // their decoders take vastly different code paths.
+    std::string identifyFormat(const std::vector<unsigned char>& data) {
+        auto startsWith = [&](const char* signature, size_t len) {
+            return data.size() >= len && memcmp(data.data(), signature, len) == 0;
+        };
+
+        if (startsWith("\xFF\xD8", 2)) {
+            for (size_t i = 2; i + 1 < data.size(); ++i) {
+                if (data[i] == 0xFF && (data[i + 1] == 0xC0 || data[i + 1] == 0xC1)) {
+                    return "jpeg-baseline";
+                } else if (data[i] == 0xFF && data[i + 1] == 0xC2) {
+                    return "jpeg-progressive";
+                }
+            }
+
+            return "jpeg";
+        }
+
+        if (startsWith("\x89PNG", 4)) {
+            return "png";
+        } else if (startsWith("#?", 2)) {
+            return "hdr";
+        } else if (startsWith("GIF8", 4)) {
+            return "gif";
+        } else if (startsWith("BM", 2)) {
+            return "bmp";
+        } else if (startsWith("8BPS", 4)) {
+            return "psd";
+        }
+
+        return "other";
+    }
+
+    size_t peakRssBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return 0;
+        }
+
+        return counters.PeakWorkingSetSize;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+
+    #ifdef __APPLE__
+        return (size_t)usage.ru_maxrss;
+    #else
+        return (size_t)usage.ru_maxrss * 1024;
+    #endif
+#endif
+    }
+
+    double percentile(std::vector<double>& sorted, double p) {
+        if (sorted.empty()) {
+            return 0;
+        }
+
+        size_t i = std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5));
+        return sorted[i];
+    }
+
+    // Decodes a single image through one of the per-image exports. Returns false on failure.
+    using DecodeFunction = bool (*)(const Image& image, int nChannels, std::vector<unsigned char>& scratch);
+
+    struct Export {
+        const char* name;
+        DecodeFunction decode;
+    };
+
+    const Export exports[] = {
+        {"LoadFromMemory", [](const Image& image, int nChannels, std::vector<unsigned char>&) {
+            int w, h, n;
+            unsigned char* pixels = LoadFromMemory(image.data.data(), (int64_t)image.data.size(), &w, &h, &n, nChannels);
+            Free(pixels);
+            return pixels != nullptr;
+        }},
+        {"LoadFromMemoryIntoBuffer", [](const Image& image, int nChannels, std::vector<unsigned char>& scratch) {
+            if (scratch.size() < image.decodedSize) {
+                scratch.resize(image.decodedSize);
+            }
+
+            return LoadFromMemoryIntoBuffer(image.data.data(), (int64_t)image.data.size(), nChannels, scratch.data());
+        }},
+        {"Load16FromMemory", [](const Image& image, int nChannels, std::vector<unsigned char>&) {
+            int w, h, n;
+            unsigned short* pixels = Load16FromMemory(image.data.data(), (int64_t)image.data.size(), &w, &h, &n, nChannels);
+            Free((unsigned char*)pixels);
+            return pixels != nullptr;
+        }},
+        {"LoadFFromMemory", [](const Image& image, int nChannels, std::vector<unsigned char>&) {
+            int w, h, n;
+            float* pixels = LoadFFromMemory(image.data.data(), (int64_t)image.data.size(), &w, &h, &n, nChannels);
+            Free((unsigned char*)pixels);
+            return pixels != nullptr;
+        }},
+    };
+
+    void report(const char* exportName, const Group& group, int nThreads, int nIterations, double seconds, std::vector<double>& latencies, size_t nFailures) {
+        std::sort(latencies.begin(), latencies.end());
+        double nImages = (double)group.images.size() * nIterations;
+        double nBytes = (double)group.totalBytes * nIterations;
+        printf(
+            "%-26s %-18s %7d %12.1f %10.1f %10.3f %10.3f %8zu\n",
+            exportName, group.format.c_str(), nThreads,
+            nImages / seconds, nBytes / seconds / 1e6,
+            percentile(latencies, 0.5) * 1e3, percentile(latencies, 0.99) * 1e3,
+            nFailures
+        );
+    }
+
+    void benchExport(const Export& e, const Group& group, int nThreads, int nIterations, int nChannels) {
+        size_t nTasks = group.images.size() * nIterations;
+        std::atomic<size_t> nextTask{0};
+        std::atomic<size_t> nFailures{0};
+        std::vector<std::vector<double>> latencies(nThreads);
+
+        auto worker = [&](int id) {
+            std::vector<unsigned char> scratch;
+            for (size_t task; (task = nextTask++) < nTasks;) {
+                const Image& image = group.images[task % group.images.size()];
+                auto start = Clock::now();
+                if (!e.decode(image, nChannels, scratch)) {
+                    ++nFailures;
+                }
+
+                latencies[id].push_back(std::chrono::duration<double>(Clock::now() - start).count());
+            }
+        };
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < nThreads; ++i) {
+            threads.emplace_back(worker, i);
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<double> allLatencies;
+        for (const auto& l : latencies) {
+            allLatencies.insert(allLatencies.end(), l.begin(), l.end());
+        }
+
+        report(e.name, group, nThreads, nIterations, seconds, allLatencies, nFailures);
+    }
+
+    // LoadBatch parallelizes internally, so it is invoked from a single thread. Its latency is that of an entire batch.
+    void benchBatch(const Group& group, int nThreads, int nIterations, int nChannels) {
+        std::vector<BatchItem> items(group.images.size());
+        std::vector<double> latencies;
+        size_t nFailures = 0;
+
+        auto start = Clock::now();
+        for (int i = 0; i < nIterations; ++i) {
+            for (size_t j = 0; j < items.size(); ++j) {
+                items[j] = BatchItem{};
+                items[j].data = group.images[j].data.data();
+                items[j].len = (int64_t)group.images[j].data.size();
+                items[j].nDesiredChannels = nChannels;
+            }
+
+            auto batchStart = Clock::now();
+            LoadBatch(items.data(), (int64_t)items.size(), nThreads);
+            latencies.push_back(std::chrono::duration<double>(Clock::now() - batchStart).count());
+
+            for (auto& item : items) {
+                if (item.status != 0) {
+                    ++nFailures;
+                }
+
+                Free(item.dst);
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        report("LoadBatch", group, nThreads, nIterations, seconds, latencies, nFailures);
+    }
+
+    void printUsage() {
+        fprintf(stderr, "Usage: stbi_bench [--threads N] [--iterations K] [--channels C] <image files...>\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    int nIterations = 10;
+    int nChannels = 4;
+    std::vector<const char*> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            maxThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            nIterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--channels") == 0 && i + 1 < argc) {
+            nChannels = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty() || maxThreads < 1 || nIterations < 1 || nChannels < 0 || nChannels > 4) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Group> groups;
+    for (const char* path : paths) {
+        Image image;
+        image.path = path;
+        if (!readFile(path, image.data)) {
+            fprintf(stderr, "Could not read %s\n", path);
+            return 1;
+        }
+
+        int w, h, n;
+        if (!InfoFromMemory(image.data.data(), (int64_t)image.data.size(), &w, &h, &n)) {
+            fprintf(stderr, "Skipping %s, which is not a supported image\n", path);
+            continue;
+        }
+
+        image.decodedSize = (size_t)w * h * (nChannels == 0 ? n : nChannels);
+
+        std::string format = identifyFormat(image.data);
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const Group& g) { return g.format == format; });
+        if (group == groups.end()) {
+            groups.emplace_back();
+            group = groups.end() - 1;
+            group->format = format;
+        }
+
+        group->totalBytes += image.data.size();
+        group->images.emplace_back(std::move(image));
+    }
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+
+    threadCounts.push_back(maxThreads);
+
+    printf("%-26s %-18s %7s %12s %10s %10s %10s %8s\n", "export", "format", "threads", "images/s", "MB/s", "p50 [ms]", "p99 [ms]", "failures");
+    for (const auto& group : groups) {
+        for (const auto& e : exports) {
+            for (int t : threadCounts) {
+                benchExport(e, group, t, nIterations, nChannels);
+            }
+        }
+
+        for (int t : threadCounts) {
+            benchBatch(group, t, nIterations, nChannels);
+        }
+    }
+
+    printf("peak RSS: %.1f MB\n", peakRssBytes() / 1e6);
+    return 0;
+}
@@ -0,0 +1,22 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "compress.h"
+
+#include "allocator.h"
+
+// Matches the allocators of stbi.cpp's copy of stb_image_write, which frees the buffers that zlibCompress returns.
+#define STBIW_MALLOC(size) stbiMalloc(size)
+#define STBIW_REALLOC(p, size) stbiRealloc(p, size)
+#define STBIW_FREE(p) stbiFree(p)
+
+#define STBIW_ASSERT(x)
+#define STBI_WRITE_NO_STDIO
+// Keeps this copy's symbols from clashing with those of stbi.cpp.
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+unsigned char* zlibCompress(unsigned char* data, int len, int* outLen, int level) {
+    return stbi_zlib_compress(data, len, outLen, level);
+}
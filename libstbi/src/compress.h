@@ -0,0 +1,12 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+// Compresses len bytes of data into a zlib stream with stb_image_write's built-in compressor at the given level, from 1
+// (fastest) to 9 (smallest). Returns a buffer of *outLen bytes that is to be freed with stbiFree, or null on failure.
+//
+// stb_image_write reads the level of its PNG encoder from the process-wide stbi_write_png_compression_level, so stbi.cpp
+// overrides the encoder's compressor via STBIW_ZLIB_COMPRESS, which removes the built-in one from its copy of
+// stb_image_write. This translation unit keeps a private copy to compress with.
+unsigned char* zlibCompress(unsigned char* data, int len, int* outLen, int level);
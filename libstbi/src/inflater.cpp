@@ -0,0 +1,338 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "inflater.h"
+
+#include <string.h>
+
+namespace {
+    const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    const unsigned char LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const unsigned char DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    // The order in which the lengths of the code length code are stored.
+    const unsigned char CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    unsigned reverseBits(unsigned code, int n) {
+        unsigned reversed = 0;
+        for (int i = 0; i < n; ++i) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+
+        return reversed;
+    }
+}
+
+// Incomplete codes are accepted, as deflate streams with a single distance code rely on them, but oversubscribed ones are not.
+bool Inflater::Huffman::build(const unsigned char* lengths, int nSymbols) {
+    memset(counts, 0, sizeof(counts));
+    memset(fast, 0, sizeof(fast));
+    for (int s = 0; s < nSymbols; ++s) {
+        ++counts[lengths[s]];
+    }
+
+    counts[0] = 0;
+    int left = 1;
+    for (int len = 1; len <= MAX_BITS; ++len) {
+        left = (left << 1) - counts[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    uint16_t offsets[MAX_BITS + 2];
+    unsigned nextCode[MAX_BITS + 1];
+    offsets[1] = 0;
+    nextCode[0] = 0;
+    unsigned code = 0;
+    for (int len = 1; len <= MAX_BITS; ++len) {
+        offsets[len + 1] = offsets[len] + counts[len];
+        code = (code + counts[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+
+    for (int s = 0; s < nSymbols; ++s) {
+        int len = lengths[s];
+        if (len == 0) {
+            continue;
+        }
+
+        symbols[offsets[len]++] = (uint16_t)s;
+        unsigned c = nextCode[len]++;
+        if (len <= FAST_BITS) {
+            for (unsigned i = reverseBits(c, len); i < (1u << FAST_BITS); i += 1u << len) {
+                fast[i] = (uint16_t)((len << FAST_BITS) | s);
+            }
+        }
+    }
+
+    return true;
+}
+
+Inflater::Inflater(Source source, void* user, bool parseHeader) :
+mSource{source}, mUser{user}, mState{parseHeader ? State::Header : State::BlockHeader}, mWindow(WINDOW_SIZE) {}
+
+bool Inflater::fail(const char* error) {
+    if (!mError) {
+        mError = error;
+    }
+
+    mState = State::Done;
+    mCopyLen = 0;
+    return false;
+}
+
+unsigned char Inflater::nextByte() {
+    while (mIn == mInEnd && !mExhausted) {
+        const unsigned char* data;
+        size_t len;
+        if (!mSource(mUser, &data, &len)) {
+            mExhausted = true;
+            break;
+        }
+
+        mIn = data;
+        mInEnd = data + len;
+    }
+
+    if (mIn == mInEnd) {
+        ++mNPaddingBytes;
+        return 0;
+    }
+
+    return *mIn++;
+}
+
+void Inflater::refill() {
+    while (mNBits <= 56) {
+        mBits |= (uint64_t)nextByte() << mNBits;
+        mNBits += 8;
+    }
+}
+
+unsigned Inflater::bits(int n) {
+    if (mNBits < n) {
+        refill();
+    }
+
+    unsigned v = (unsigned)(mBits & ((1ull << n) - 1));
+    mBits >>= n;
+    mNBits -= n;
+    return v;
+}
+
+int Inflater::decode(const Huffman& huffman) {
+    if (mNBits < MAX_BITS) {
+        refill();
+    }
+
+    unsigned entry = huffman.fast[mBits & ((1u << FAST_BITS) - 1)];
+    if (entry) {
+        int len = (int)(entry >> FAST_BITS);
+        mBits >>= len;
+        mNBits -= len;
+        return (int)(entry & ((1u << FAST_BITS) - 1));
+    }
+
+    // Codes that are longer than FAST_BITS are decoded bit by bit, as they are rare.
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= MAX_BITS; ++len) {
+        code |= (int)(mBits & 1);
+        mBits >>= 1;
+        --mNBits;
+
+        int count = huffman.counts[len];
+        if (code - first < count) {
+            return huffman.symbols[index + code - first];
+        }
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+bool Inflater::readDynamicCodes() {
+    int nLiterals = (int)bits(5) + 257;
+    int nDistances = (int)bits(5) + 1;
+    int nCodeLengths = (int)bits(4) + 4;
+    if (nLiterals > 286 || nDistances > 30) {
+        return fail("bad codelengths");
+    }
+
+    unsigned char lengths[286 + 30] = {};
+    for (int i = 0; i < nCodeLengths; ++i) {
+        lengths[CODE_LENGTH_ORDER[i]] = (unsigned char)bits(3);
+    }
+
+    Huffman codeLengths;
+    if (!codeLengths.build(lengths, 19)) {
+        return fail("bad codelengths");
+    }
+
+    for (int i = 0; i < nLiterals + nDistances;) {
+        int symbol = decode(codeLengths);
+        if (symbol < 0) {
+            return fail("bad codelengths");
+        }
+
+        if (symbol < 16) {
+            lengths[i++] = (unsigned char)symbol;
+            continue;
+        }
+
+        int n;
+        unsigned char len = 0;
+        if (symbol == 16) {
+            if (i == 0) {
+                return fail("bad codelengths");
+            }
+
+            len = lengths[i - 1];
+            n = 3 + (int)bits(2);
+        } else if (symbol == 17) {
+            n = 3 + (int)bits(3);
+        } else {
+            n = 11 + (int)bits(7);
+        }
+
+        if (i + n > nLiterals + nDistances) {
+            return fail("bad codelengths");
+        }
+
+        memset(lengths + i, len, n);
+        i += n;
+    }
+
+    if (lengths[256] == 0 || !mLiterals.build(lengths, nLiterals) || !mDistances.build(lengths + nLiterals, nDistances)) {
+        return fail("bad codelengths");
+    }
+
+    return true;
+}
+
+bool Inflater::readBlockHeader() {
+    if (mFinal) {
+        return fail("unexpected end");
+    }
+
+    mFinal = bits(1) != 0;
+    switch (bits(2)) {
+        case 0: {
+            // Stored blocks begin at the next byte boundary.
+            bits(mNBits % 8);
+            unsigned len = bits(16);
+            unsigned nlen = bits(16);
+            if ((len ^ 0xFFFF) != nlen) {
+                return fail("zlib corrupt");
+            }
+
+            mStoredLen = len;
+            mState = State::Stored;
+            return true;
+        }
+        case 1: {
+            unsigned char lengths[288 + 30];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            memset(lengths + 288, 5, 30);
+            mLiterals.build(lengths, 288);
+            mDistances.build(lengths + 288, 30);
+            mState = State::Compressed;
+            return true;
+        }
+        case 2:
+            if (!readDynamicCodes()) {
+                return false;
+            }
+
+            mState = State::Compressed;
+            return true;
+        default:
+            return fail("bad block type");
+    }
+}
+
+bool Inflater::read(unsigned char* dst, size_t len) {
+    while (len > 0) {
+        if (mCopyLen > 0) {
+            size_t n = mCopyLen < len ? mCopyLen : len;
+            for (size_t i = 0; i < n; ++i) {
+                put(mWindow[(mPos - mCopyDist) & WINDOW_MASK], dst);
+            }
+
+            mCopyLen -= n;
+            len -= n;
+            continue;
+        }
+
+        switch (mState) {
+            case State::Header: {
+                unsigned cmf = bits(8), flg = bits(8);
+                if ((cmf * 256 + flg) % 31 != 0 || (cmf & 15) != 8 || (flg & 32) != 0) {
+                    return fail("bad zlib header");
+                }
+
+                mState = State::BlockHeader;
+                break;
+            }
+            case State::BlockHeader:
+                if (!readBlockHeader()) {
+                    return false;
+                }
+
+                break;
+            case State::Stored:
+                if (mStoredLen == 0) {
+                    mState = State::BlockHeader;
+                    break;
+                }
+
+                put((unsigned char)bits(8), dst);
+                --mStoredLen;
+                --len;
+                break;
+            case State::Compressed: {
+                int symbol = decode(mLiterals);
+                if (symbol < 0) {
+                    return fail("bad huffman code");
+                } else if (symbol < 256) {
+                    put((unsigned char)symbol, dst);
+                    --len;
+                } else if (symbol == 256) {
+                    mState = State::BlockHeader;
+                } else {
+                    symbol -= 257;
+                    if (symbol >= 29) {
+                        return fail("bad huffman code");
+                    }
+
+                    mCopyLen = LENGTH_BASE[symbol] + bits(LENGTH_EXTRA[symbol]);
+                    int distance = decode(mDistances);
+                    if (distance < 0 || distance >= 30) {
+                        return fail("bad huffman code");
+                    }
+
+                    mCopyDist = DISTANCE_BASE[distance] + bits(DISTANCE_EXTRA[distance]);
+                    if (mCopyDist > mPos) {
+                        return fail("bad dist");
+                    }
+                }
+
+                break;
+            }
+            case State::Done:
+                return fail("unexpected end");
+        }
+
+        if (overran()) {
+            return fail("unexpected end");
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,100 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <vector>
+
+// Inflates a zlib stream, or a raw deflate stream, piece by piece. Unlike stb_image's inflate, which grows a buffer until the
+// entire output fits, only the 32 KiB that deflate may refer back to are kept, so memory does not depend on the size of
+// the output. The input is pulled from a callback, such that it may be split across several buffers, like the IDAT chunks
+// of a PNG. The Adler-32 checksum is not verified, as in stb_image.
+class Inflater {
+public:
+    // Points data and len at the next piece of the input, which has to stay valid until the following call. Returns false
+    // once the input is exhausted.
+    using Source = bool (*)(void* user, const unsigned char** data, size_t* len);
+
+    Inflater(Source source, void* user, bool parseHeader);
+
+    // Writes the next len bytes of the output to dst. Returns false if the stream is corrupt or ends before len bytes were
+    // produced, in which case error() describes why and all further reads fail.
+    bool read(unsigned char* dst, size_t len);
+
+    const char* error() const {
+        return mError;
+    }
+
+private:
+    static const int FAST_BITS = 9;
+    static const int MAX_BITS = 15;
+
+    // A canonical Huffman code. Codes of at most FAST_BITS bits are decoded with a single lookup of the next bits of the
+    // input, whose entries are (length << FAST_BITS) | symbol, or 0 for longer codes.
+    struct Huffman {
+        uint16_t fast[1 << FAST_BITS];
+        uint16_t counts[MAX_BITS + 1];
+        uint16_t symbols[288];
+
+        bool build(const unsigned char* lengths, int nSymbols);
+    };
+
+    enum class State {
+        Header,
+        BlockHeader,
+        Stored,
+        Compressed,
+        Done,
+    };
+
+    bool fail(const char* error);
+
+    unsigned char nextByte();
+    void refill();
+    unsigned bits(int n);
+    int decode(const Huffman& huffman);
+    // Whether more bits were consumed than the input holds.
+    bool overran() const {
+        return (int64_t)mNPaddingBytes * 8 > mNBits;
+    }
+
+    bool readBlockHeader();
+    bool readDynamicCodes();
+
+    void put(unsigned char b, unsigned char*& dst) {
+        mWindow[mPos++ & WINDOW_MASK] = b;
+        *dst++ = b;
+    }
+
+    static const size_t WINDOW_SIZE = 32768;
+    static const size_t WINDOW_MASK = WINDOW_SIZE - 1;
+
+    Source mSource;
+    void* mUser;
+
+    const unsigned char* mIn = nullptr;
+    const unsigned char* mInEnd = nullptr;
+    bool mExhausted = false;
+    // Zeros that were shifted into the bit buffer past the end of the input.
+    int mNPaddingBytes = 0;
+
+    uint64_t mBits = 0;
+    int mNBits = 0;
+
+    State mState;
+    bool mFinal = false;
+    size_t mStoredLen = 0;
+    size_t mCopyLen = 0;
+    size_t mCopyDist = 0;
+
+    Huffman mLiterals;
+    Huffman mDistances;
+
+    std::vector<unsigned char> mWindow;
+    // The number of bytes that were produced so far, whose low bits index the window.
+    uint64_t mPos = 0;
+
+    const char* mError = nullptr;
+};
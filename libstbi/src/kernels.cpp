@@ -0,0 +1,388 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "kernels.h"
+
+#include <inttypes.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define STBI_KERNELS_SSE2
+    #include <emmintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define STBI_KERNELS_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+    using Convert4Function = void (*)(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha);
+
+    // Exact round(v * a / 255) for v, a in [0, 255]. The SIMD kernels compute the same expression in 16-bit lanes.
+    inline unsigned char mulDiv255(unsigned v, unsigned a) {
+        unsigned t = v * a + 128;
+        return (unsigned char)((t + (t >> 8)) >> 8);
+    }
+}
+
+void convert4Scalar(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha) {
+    for (size_t i = 0; i < nPixels; ++i) {
+        unsigned char* p = pixels + i * 4;
+        unsigned char r = p[0], g = p[1], b = p[2], a = p[3];
+        if (premultiplyAlpha) {
+            r = mulDiv255(r, a);
+            g = mulDiv255(g, a);
+            b = mulDiv255(b, a);
+        }
+
+        switch (order) {
+            case ChannelOrderBgra: p[0] = b; p[1] = g; p[2] = r; p[3] = a; break;
+            case ChannelOrderArgb: p[0] = a; p[1] = r; p[2] = g; p[3] = b; break;
+            default:               p[0] = r; p[1] = g; p[2] = b; p[3] = a; break;
+        }
+    }
+}
+
+namespace {
+#ifdef STBI_KERNELS_SSE2
+    // Multiplies the colour channels of 2 pixels in 16-bit lanes by their alpha. Alpha itself is multiplied by 255,
+    // which leaves it unchanged.
+    inline __m128i premultiply2Sse2(__m128i v) {
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm_or_si128(
+            _mm_and_si128(a, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)),
+            _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0)
+        );
+
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    // Pixels are little-endian 32-bit lanes, with R in the lowest byte.
+    inline __m128i swizzle4Sse2(__m128i v, ChannelOrder order) {
+        switch (order) {
+            case ChannelOrderBgra: {
+                __m128i red = _mm_set1_epi32(0xFF);
+                return _mm_or_si128(
+                    _mm_and_si128(v, _mm_set1_epi32((int)0xFF00FF00)),
+                    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), red), _mm_slli_epi32(_mm_and_si128(v, red), 16))
+                );
+            }
+            case ChannelOrderArgb:
+                return _mm_or_si128(_mm_slli_epi32(v, 8), _mm_srli_epi32(v, 24));
+            default:
+                return v;
+        }
+    }
+
+    void convert4Sse2(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha) {
+        size_t i = 0;
+        for (; i + 4 <= nPixels; i += 4) {
+            __m128i* p = (__m128i*)(pixels + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            if (premultiplyAlpha) {
+                __m128i zero = _mm_setzero_si128();
+                v = _mm_packus_epi16(
+                    premultiply2Sse2(_mm_unpacklo_epi8(v, zero)),
+                    premultiply2Sse2(_mm_unpackhi_epi8(v, zero))
+                );
+            }
+
+            _mm_storeu_si128(p, swizzle4Sse2(v, order));
+        }
+
+        convert4Scalar(pixels + i * 4, nPixels - i, order, premultiplyAlpha);
+    }
+
+#endif
+
+#ifdef STBI_KERNELS_AVX2
+    bool cpuSupportsAvx2() {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+
+        // The OS must save and restore the YMM registers on context switches.
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+        if (!osxsave || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+#endif
+
+#ifdef STBI_KERNELS_NEON
+    inline uint8x16_t premultiplyNeon(uint8x16_t v, uint8x16_t a) {
+        uint16x8_t lo = vmull_u8(vget_low_u8(v), vget_low_u8(a));
+        uint16x8_t hi = vmull_u8(vget_high_u8(v), vget_high_u8(a));
+        lo = vaddq_u16(lo, vrshrq_n_u16(lo, 8));
+        hi = vaddq_u16(hi, vrshrq_n_u16(hi, 8));
+        return vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+    }
+
+    void convert4Neon(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha) {
+        size_t i = 0;
+        for (; i + 16 <= nPixels; i += 16) {
+            unsigned char* p = pixels + i * 4;
+            uint8x16x4_t v = vld4q_u8(p);
+            if (premultiplyAlpha) {
+                v.val[0] = premultiplyNeon(v.val[0], v.val[3]);
+                v.val[1] = premultiplyNeon(v.val[1], v.val[3]);
+                v.val[2] = premultiplyNeon(v.val[2], v.val[3]);
+            }
+
+            uint8x16x4_t out = v;
+            switch (order) {
+                case ChannelOrderBgra: out.val[0] = v.val[2]; out.val[2] = v.val[0]; break;
+                case ChannelOrderArgb: out.val[0] = v.val[3]; out.val[1] = v.val[0]; out.val[2] = v.val[1]; out.val[3] = v.val[2]; break;
+                default: break;
+            }
+
+            vst4q_u8(p, out);
+        }
+
+        convert4Scalar(pixels + i * 4, nPixels - i, order, premultiplyAlpha);
+    }
+#endif
+
+#if defined(STBI_KERNELS_SSE2)
+    // Averages 2 consecutive pixels of 2 rows into 1 pixel for each half of a 128-bit register.
+    inline __m128i average2x2Sse2(__m128i row0, __m128i row1) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi16(2));
+        return _mm_srli_epi16(sum, 2);
+    }
+
+    // Returns the number of produced pixels, which is a multiple of 4.
+    int downsampleRow4Simd(const unsigned char* row0, const unsigned char* row1, int nDstPixels, unsigned char* dst) {
+        int x = 0;
+        for (; x + 4 <= nDstPixels; x += 4) {
+            __m128i a = average2x2Sse2(_mm_loadu_si128((const __m128i*)(row0 + x * 8)), _mm_loadu_si128((const __m128i*)(row1 + x * 8)));
+            __m128i b = average2x2Sse2(_mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16)), _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16)));
+            _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(a, b));
+        }
+
+        return x;
+    }
+#elif defined(STBI_KERNELS_NEON)
+    // Returns the number of produced pixels, which is a multiple of 8.
+    int downsampleRow4Simd(const unsigned char* row0, const unsigned char* row1, int nDstPixels, unsigned char* dst) {
+        int x = 0;
+        for (; x + 8 <= nDstPixels; x += 8) {
+            uint8x16x4_t a = vld4q_u8(row0 + x * 8);
+            uint8x16x4_t b = vld4q_u8(row1 + x * 8);
+            uint8x8x4_t out;
+            for (int c = 0; c < 4; ++c) {
+                out.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c])), 2);
+            }
+
+            vst4_u8(dst + x * 4, out);
+        }
+
+        return x;
+    }
+#else
+    int downsampleRow4Simd(const unsigned char*, const unsigned char*, int, unsigned char*) {
+        return 0;
+    }
+#endif
+
+    // Linear light in 16-bit fixed point, and its inverse for every 16-bit value, such that averaging in linear light
+    // rounds exactly like the scalar math would.
+    struct SrgbTables {
+        uint16_t toLinear[256];
+        unsigned char fromLinear[65536];
+
+        SrgbTables() {
+            for (int i = 0; i < 256; ++i) {
+                double c = i / 255.0;
+                double l = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+                toLinear[i] = (uint16_t)(l * 65535 + 0.5);
+            }
+
+            for (int i = 0; i < 65536; ++i) {
+                double l = i / 65535.0;
+                double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1 / 2.4) - 0.055;
+                fromLinear[i] = (unsigned char)(c * 255 + 0.5);
+            }
+        }
+    };
+
+    const SrgbTables& srgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    struct Convert4Kernel {
+        Convert4Function convert;
+        const char* name;
+    };
+
+    Convert4Kernel selectConvert4() {
+#if defined(STBI_KERNELS_AVX2)
+        if (cpuSupportsAvx2()) {
+            return {convert4Avx2, "avx2"};
+        }
+#endif
+
+#if defined(STBI_KERNELS_SSE2)
+        return {convert4Sse2, "sse2"};
+#elif defined(STBI_KERNELS_NEON)
+        return {convert4Neon, "neon"};
+#else
+        return {convert4Scalar, "scalar"};
+#endif
+    }
+
+    const Convert4Kernel& convert4Kernel() {
+        static const Convert4Kernel kernel = selectConvert4();
+        return kernel;
+    }
+}
+
+void downsample2x2(const unsigned char* src, int w, int h, int nChannels, bool srgb, unsigned char* dst) {
+    int dstW = w / 2 > 0 ? w / 2 : 1;
+    int dstH = h / 2 > 0 ? h / 2 : 1;
+    size_t srcStride = (size_t)w * nChannels;
+    bool hasAlpha = nChannels == 2 || nChannels == 4;
+    const SrgbTables* tables = srgb ? &srgbTables() : nullptr;
+
+    for (int y = 0; y < dstH; ++y) {
+        const unsigned char* row0 = src + (size_t)(2 * y) * srcStride;
+        const unsigned char* row1 = src + (size_t)(2 * y + 1 < h ? 2 * y + 1 : 2 * y) * srcStride;
+        unsigned char* out = dst + (size_t)y * dstW * nChannels;
+
+        // Images that are 1 pixel wide have no pairs of pixels to average.
+        int x = nChannels == 4 && !srgb && w > 1 ? downsampleRow4Simd(row0, row1, dstW, out) : 0;
+        for (; x < dstW; ++x) {
+            int x0 = 2 * x;
+            int x1 = 2 * x + 1 < w ? 2 * x + 1 : 2 * x;
+            for (int c = 0; c < nChannels; ++c) {
+                unsigned a = row0[x0 * nChannels + c], b = row0[x1 * nChannels + c];
+                unsigned d = row1[x0 * nChannels + c], e = row1[x1 * nChannels + c];
+                if (tables && !(hasAlpha && c == nChannels - 1)) {
+                    unsigned sum = tables->toLinear[a] + tables->toLinear[b] + tables->toLinear[d] + tables->toLinear[e];
+                    out[x * nChannels + c] = tables->fromLinear[(sum + 2) >> 2];
+                } else {
+                    out[x * nChannels + c] = (unsigned char)((a + b + d + e + 2) >> 2);
+                }
+            }
+        }
+    }
+}
+
+void deinterleave(const unsigned char* src, size_t nPixels, int nChannels, unsigned char* dst) {
+    size_t i = 0;
+#ifdef STBI_KERNELS_NEON
+    if (nChannels == 3) {
+        for (; i + 16 <= nPixels; i += 16) {
+            uint8x16x3_t v = vld3q_u8(src + i * 3);
+            vst1q_u8(dst + i, v.val[0]);
+            vst1q_u8(dst + nPixels + i, v.val[1]);
+            vst1q_u8(dst + 2 * nPixels + i, v.val[2]);
+        }
+    } else if (nChannels == 4) {
+        for (; i + 16 <= nPixels; i += 16) {
+            uint8x16x4_t v = vld4q_u8(src + i * 4);
+            for (int c = 0; c < 4; ++c) {
+                vst1q_u8(dst + c * nPixels + i, v.val[c]);
+            }
+        }
+    }
+#endif
+
+    for (int c = 0; c < nChannels; ++c) {
+        unsigned char* plane = dst + c * nPixels;
+        for (size_t j = i; j < nPixels; ++j) {
+            plane[j] = src[j * nChannels + c];
+        }
+    }
+}
+
+void deinterleaveToFloat(const unsigned char* src, size_t nPixels, int nChannels, const float* scale, const float* bias, float* dst) {
+    size_t i = 0;
+#if defined(STBI_KERNELS_SSE2)
+    // Gathers 4 values of a channel at a time. SSE2 has no byte shuffle, but the gather is cheap next to the float math
+    // and the stores, which make up most of the work.
+    for (int c = 0; c < nChannels; ++c) {
+        __m128 s = _mm_set1_ps(scale[c]);
+        __m128 b = _mm_set1_ps(bias[c]);
+        float* plane = dst + c * nPixels;
+        const unsigned char* p = src + c;
+        size_t n = (size_t)nChannels;
+        for (i = 0; i + 4 <= nPixels; i += 4, p += 4 * n) {
+            __m128 v = _mm_cvtepi32_ps(_mm_setr_epi32(p[0], p[n], p[2 * n], p[3 * n]));
+            _mm_storeu_ps(plane + i, _mm_add_ps(_mm_mul_ps(v, s), b));
+        }
+    }
+#elif defined(STBI_KERNELS_NEON)
+    if (nChannels == 3 || nChannels == 4) {
+        for (; i + 16 <= nPixels; i += 16) {
+            uint8x16_t channels[4];
+            if (nChannels == 3) {
+                uint8x16x3_t v = vld3q_u8(src + i * 3);
+                channels[0] = v.val[0]; channels[1] = v.val[1]; channels[2] = v.val[2];
+            } else {
+                uint8x16x4_t v = vld4q_u8(src + i * 4);
+                channels[0] = v.val[0]; channels[1] = v.val[1]; channels[2] = v.val[2]; channels[3] = v.val[3];
+            }
+
+            for (int c = 0; c < nChannels; ++c) {
+                float32x4_t s = vdupq_n_f32(scale[c]);
+                float32x4_t b = vdupq_n_f32(bias[c]);
+                uint16x8_t lo = vmovl_u8(vget_low_u8(channels[c]));
+                uint16x8_t hi = vmovl_u8(vget_high_u8(channels[c]));
+                float* plane = dst + c * nPixels + i;
+                vst1q_f32(plane, vmlaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), s));
+                vst1q_f32(plane + 4, vmlaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), s));
+                vst1q_f32(plane + 8, vmlaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), s));
+                vst1q_f32(plane + 12, vmlaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), s));
+            }
+        }
+    }
+#endif
+
+    for (int c = 0; c < nChannels; ++c) {
+        float* plane = dst + c * nPixels;
+        for (size_t j = i; j < nPixels; ++j) {
+            plane[j] = src[j * nChannels + c] * scale[c] + bias[c];
+        }
+    }
+}
+
+const char* activeChannelKernel() {
+    return convert4Kernel().name;
+}
+
+void convertChannels(unsigned char* pixels, size_t nPixels, int nChannels, ChannelOrder order, bool premultiplyAlpha) {
+    if (nChannels == 4) {
+        convert4Kernel().convert(pixels, nPixels, order, premultiplyAlpha);
+    } else if (nChannels == 3 && order == ChannelOrderBgra) {
+        for (size_t i = 0; i < nPixels; ++i) {
+            unsigned char* p = pixels + i * 3;
+            unsigned char r = p[0];
+            p[0] = p[2];
+            p[2] = r;
+        }
+    } else if (nChannels == 2 && premultiplyAlpha) {
+        for (size_t i = 0; i < nPixels; ++i) {
+            unsigned char* p = pixels + i * 2;
+            p[0] = mulDiv255(p[0], p[1]);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+
+// Memory order of the channels of 3- and 4-channel output. Mirrored by StbiChannelOrder in stbi-sharp.cs. 3-channel
+// output is BGR when BGRA is requested and RGB otherwise.
+enum ChannelOrder : int {
+    ChannelOrderRgba = 0,
+    ChannelOrderBgra = 1,
+    ChannelOrderArgb = 2,
+};
+
+// Reorders the channels of, and optionally premultiplies alpha into, 8-bit RGBA, RGB, or grey-alpha pixels in place.
+// Premultiplication rounds to nearest and is a no-op for pixels without alpha. 4-channel pixels are processed by SSE2,
+// AVX2 (see kernels_avx2.cpp), or NEON kernels, of which the fastest that the CPU supports is chosen at runtime.
+void convertChannels(unsigned char* pixels, size_t nPixels, int nChannels, ChannelOrder order, bool premultiplyAlpha);
+
+// Halves an 8-bit image of size w x h with nChannels channels per pixel in both dimensions with a 2x2 box filter that
+// rounds to nearest. dst has size max(w / 2, 1) x max(h / 2, 1), so the last column of an odd width greater than 1 and
+// the last row of an odd height greater than 1 are dropped rather than filtered into dst. A dimension of 1 is kept and its
+// pixels are averaged with themselves. When srgb is set, colour channels are averaged in linear light, whereas alpha is
+// always averaged as is. 4-channel pixels are processed by SSE2 or NEON kernels unless srgb is set.
+void downsample2x2(const unsigned char* src, int w, int h, int nChannels, bool srgb, unsigned char* dst);
+
+// Splits nPixels 8-bit pixels of nChannels interleaved channels into nChannels planes of nPixels values each, which
+// are stored one after another in dst.
+void deinterleave(const unsigned char* src, size_t nPixels, int nChannels, unsigned char* dst);
+
+// Like deinterleave, but stores each value v of channel c as v * scale[c] + bias[c], e.g. to normalize images by the
+// per-channel mean and standard deviation of a neural network's training data in the same pass.
+void deinterleaveToFloat(const unsigned char* src, size_t nPixels, int nChannels, const float* scale, const float* bias, float* dst);
+
+// The name of the kernel that convertChannels uses for 4-channel pixels on this CPU: "avx2", "sse2", "neon", or "scalar".
+const char* activeChannelKernel();
+
+// Per-ISA implementations of convertChannels for 4-channel pixels. Not to be called directly, because the CPU may not
+// support them.
+void convert4Scalar(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha);
+void convert4Avx2(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha);
@@ -0,0 +1,63 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+// Compiled with AVX2 enabled (see CMakeLists.txt), such that the compiler may also use AVX2 for the surrounding scalar
+// code. Only called after kernels.cpp confirmed at runtime that the CPU supports AVX2.
+
+#include "kernels.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace {
+    inline __m256i premultiply2Avx2(__m256i v) {
+        __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm256_or_si256(
+            _mm256_and_si256(a, _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1)),
+            _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0)
+        );
+
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(v, a), _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    inline __m256i swizzle4Avx2(__m256i v, ChannelOrder order) {
+        switch (order) {
+            case ChannelOrderBgra:
+                return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+                ));
+            case ChannelOrderArgb:
+                return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                    3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                    3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14
+                ));
+            default:
+                return v;
+        }
+    }
+}
+
+void convert4Avx2(unsigned char* pixels, size_t nPixels, ChannelOrder order, bool premultiplyAlpha) {
+    size_t i = 0;
+    for (; i + 8 <= nPixels; i += 8) {
+        __m256i* p = (__m256i*)(pixels + i * 4);
+        __m256i v = _mm256_loadu_si256(p);
+        if (premultiplyAlpha) {
+            // Unpacking and packing both operate within 128-bit lanes, so they cancel out and pixel order is kept.
+            __m256i zero = _mm256_setzero_si256();
+            v = _mm256_packus_epi16(
+                premultiply2Avx2(_mm256_unpacklo_epi8(v, zero)),
+                premultiply2Avx2(_mm256_unpackhi_epi8(v, zero))
+            );
+        }
+
+        _mm256_storeu_si256(p, swizzle4Avx2(v, order));
+    }
+
+    convert4Scalar(pixels + i * 4, nPixels - i, order, premultiplyAlpha);
+}
+
+#endif
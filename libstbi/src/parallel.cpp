@@ -0,0 +1,22 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <system_error>
+
+WorkerPool* parallelPool() {
+    // Intentionally leaked, like the async pool of stbi.cpp, such that its threads are not joined while the library is being
+    // unloaded.
+    static WorkerPool* pool = []() -> WorkerPool* {
+        int nThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+        try {
+            return new WorkerPool{nThreads, (size_t)nThreads * 4};
+        } catch (const std::system_error&) {
+            return nullptr;
+        }
+    }();
+
+    return pool;
+}
@@ -0,0 +1,142 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include "workers.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The pool whose threads help out the callers of parallelFor. It has one thread per hardware thread and persists for the
+// lifetime of the process, such that parallel loads neither spawn threads nor lose the arenas of their threads between
+// calls. Null if not even one thread could be created.
+WorkerPool* parallelPool();
+
+// Invokes f(i) for every i in [0, nItems) on up to nThreads threads, one of which is the calling thread and the others of
+// which are borrowed from parallelPool. Supplying nThreads <= 0 uses one thread per hardware thread. Each thread starts out
+// with an equally sized contiguous range of items. Threads that run out of work steal the upper half of the remaining range
+// of another thread, which balances the load when items take vastly different amounts of time, as is the case when
+// decoding images of different sizes.
+//
+// Helpers are never waited for before they start, as the pool may be busy with other calls, or with the very call that
+// is waiting, which may itself run on a thread of the pool. Their ranges are stolen by the threads that did start instead.
+template <typename F>
+void parallelFor(size_t nItems, int nThreads, F f) {
+    if (nThreads <= 0) {
+        nThreads = (int)std::thread::hardware_concurrency();
+    }
+
+    if ((size_t)nThreads > nItems) {
+        nThreads = (int)nItems;
+    }
+
+    if (nThreads <= 1) {
+        for (size_t i = 0; i < nItems; ++i) {
+            f(i);
+        }
+
+        return;
+    }
+
+    struct Range {
+        std::mutex mutex;
+        size_t begin, end;
+    };
+
+    // Shared with the helpers, which may only be dequeued after the call returned. Such helpers do not touch the ranges.
+    struct State {
+        State(int nRanges) : ranges(nRanges) {}
+
+        std::vector<Range> ranges;
+        std::mutex mutex;
+        std::condition_variable idle;
+        int nActive = 0;
+        bool closed = false;
+    };
+
+    auto state = std::make_shared<State>(nThreads);
+    std::vector<Range>& ranges = state->ranges;
+    for (int i = 0; i < nThreads; ++i) {
+        ranges[i].begin = nItems * i / nThreads;
+        ranges[i].end = nItems * (i + 1) / nThreads;
+    }
+
+    auto worker = [&](int id) {
+        Range& own = ranges[id];
+        for (;;) {
+            size_t item;
+            bool hasItem = false;
+
+            {
+                std::lock_guard<std::mutex> lock{own.mutex};
+                if (own.begin < own.end) {
+                    item = own.begin++;
+                    hasItem = true;
+                }
+            }
+
+            if (hasItem) {
+                f(item);
+                continue;
+            }
+
+            // Only one lock is held at any time, so that thieves can not deadlock each other.
+            size_t stolenBegin = 0, stolenEnd = 0;
+            for (int i = 1; i < nThreads && stolenBegin == stolenEnd; ++i) {
+                Range& victim = ranges[(id + i) % nThreads];
+                std::lock_guard<std::mutex> lock{victim.mutex};
+                if (victim.begin < victim.end) {
+                    stolenBegin = victim.begin + (victim.end - victim.begin) / 2;
+                    stolenEnd = victim.end;
+                    victim.end = stolenBegin;
+                }
+            }
+
+            if (stolenBegin == stolenEnd) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock{own.mutex};
+            own.begin = stolenBegin;
+            own.end = stolenEnd;
+        }
+    };
+
+    // A full queue means that the pool is saturated anyway, so the call makes do with the helpers that it already has.
+    WorkerPool* pool = parallelPool();
+    for (int i = 1; i < nThreads && pool; ++i) {
+        bool submitted = pool->trySubmit([state, &worker, i] {
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                if (state->closed) {
+                    return;
+                }
+
+                ++state->nActive;
+            }
+
+            worker(i);
+
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                --state->nActive;
+            }
+
+            state->idle.notify_all();
+        });
+
+        if (!submitted) {
+            break;
+        }
+    }
+
+    worker(0);
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->closed = true;
+    state->idle.wait(lock, [&] { return state->nActive == 0; });
+}
@@ -0,0 +1,110 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <string.h>
+
+namespace {
+    std::atomic<bool> enabled{false};
+
+    struct AtomicFormatStats {
+        std::atomic<int64_t> nDecodes{0};
+        std::atomic<int64_t> nFailures{0};
+        std::atomic<int64_t> nBytesIn{0};
+        std::atomic<int64_t> nBytesOut{0};
+        std::atomic<int64_t> headerNanoseconds{0};
+        std::atomic<int64_t> decodeNanoseconds{0};
+        std::atomic<int64_t> postNanoseconds{0};
+    };
+
+    AtomicFormatStats stats[ImageFormatCount];
+
+    AtomicFormatStats& statsOf(ImageFormat format) {
+        return stats[format >= 0 && format < ImageFormatCount ? format : ImageFormatOther];
+    }
+}
+
+ImageFormat identifyFormat(const unsigned char* data, int64_t len) {
+    auto startsWith = [&](const char* signature, int64_t n) {
+        return len >= n && memcmp(data, signature, (size_t)n) == 0;
+    };
+
+    if (startsWith("\xFF\xD8", 2)) {
+        return ImageFormatJpeg;
+    } else if (startsWith("\x89PNG", 4)) {
+        return ImageFormatPng;
+    } else if (startsWith("BM", 2)) {
+        return ImageFormatBmp;
+    } else if (startsWith("GIF8", 4)) {
+        return ImageFormatGif;
+    } else if (startsWith("8BPS", 4)) {
+        return ImageFormatPsd;
+    } else if (startsWith("#?", 2)) {
+        return ImageFormatHdr;
+    } else if (len >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6')) {
+        return ImageFormatPnm;
+    } else if (startsWith("\x53\x80\xF6\x34", 4)) {
+        return ImageFormatPic;
+    }
+
+    return ImageFormatOther;
+}
+
+void setStatsEnabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool statsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void recordHeader(ImageFormat format, int64_t nanoseconds) {
+    statsOf(format).headerNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void recordDecode(ImageFormat format, bool success, int64_t nBytesIn, int64_t nBytesOut, int64_t nanoseconds) {
+    AtomicFormatStats& s = statsOf(format);
+    s.nDecodes.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        s.nFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    s.nBytesIn.fetch_add(nBytesIn, std::memory_order_relaxed);
+    s.nBytesOut.fetch_add(nBytesOut, std::memory_order_relaxed);
+    s.decodeNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void recordPost(ImageFormat format, int64_t nanoseconds) {
+    statsOf(format).postNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void getStats(FormatStats* formats, int nFormats) {
+    for (int i = 0; i < nFormats && i < ImageFormatCount; ++i) {
+        formats[i].nDecodes = stats[i].nDecodes;
+        formats[i].nFailures = stats[i].nFailures;
+        formats[i].nBytesIn = stats[i].nBytesIn;
+        formats[i].nBytesOut = stats[i].nBytesOut;
+        formats[i].headerNanoseconds = stats[i].headerNanoseconds;
+        formats[i].decodeNanoseconds = stats[i].decodeNanoseconds;
+        formats[i].postNanoseconds = stats[i].postNanoseconds;
+    }
+}
+
+void resetStats() {
+    for (auto& s : stats) {
+        s.nDecodes = 0;
+        s.nFailures = 0;
+        s.nBytesIn = 0;
+        s.nBytesOut = 0;
+        s.headerNanoseconds = 0;
+        s.decodeNanoseconds = 0;
+        s.postNanoseconds = 0;
+    }
+}
@@ -0,0 +1,73 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Formats by which decode statistics are broken down, as identified by their signatures. Formats without a signature,
+// such as TGA, count as ImageFormatOther. Mirrored by StbiFormat in stbi-sharp.cs.
+enum ImageFormat : int {
+    ImageFormatJpeg = 0,
+    ImageFormatPng = 1,
+    ImageFormatBmp = 2,
+    ImageFormatGif = 3,
+    ImageFormatPsd = 4,
+    ImageFormatHdr = 5,
+    ImageFormatPnm = 6,
+    ImageFormatPic = 7,
+    ImageFormatOther = 8,
+    ImageFormatCount = 9,
+};
+
+// Aggregated over all threads since statistics were last reset. Mirrored by StbiFormatStats in stbi-sharp.cs.
+struct FormatStats {
+    int64_t nDecodes;
+    int64_t nFailures;
+    // Encoded bytes that were passed to decodes, and decoded bytes that successful decodes produced.
+    int64_t nBytesIn;
+    int64_t nBytesOut;
+    // Nanoseconds spent parsing headers, decoding pixels, and converting decoded pixels (channel order, premultiplied
+    // alpha, scaling). stb_image does not expose its internal stages, so decoding covers entropy decoding, IDCT, and
+    // colour conversion of JPEGs as well as inflating and unfiltering PNGs.
+    int64_t headerNanoseconds;
+    int64_t decodeNanoseconds;
+    int64_t postNanoseconds;
+};
+
+ImageFormat identifyFormat(const unsigned char* data, int64_t len);
+
+// Statistics are disabled by default, such that decodes do not pay for reading the clock and for the additional header
+// parse that breaks out header time.
+void setStatsEnabled(bool enabled);
+bool statsEnabled();
+
+int64_t nowNanoseconds();
+
+void recordHeader(ImageFormat format, int64_t nanoseconds);
+void recordDecode(ImageFormat format, bool success, int64_t nBytesIn, int64_t nBytesOut, int64_t nanoseconds);
+void recordPost(ImageFormat format, int64_t nanoseconds);
+
+// Copies the statistics of at most nFormats formats, indexed by ImageFormat.
+void getStats(FormatStats* formats, int nFormats);
+void resetStats();
+
+// Adds the time between its construction and destruction to the post-processing time of a format.
+class PostTimer {
+public:
+    PostTimer(ImageFormat format) : mFormat{format}, mStart{statsEnabled() ? nowNanoseconds() : -1} {}
+
+    ~PostTimer() {
+        if (mStart >= 0) {
+            recordPost(mFormat, nowNanoseconds() - mStart);
+        }
+    }
+
+    PostTimer(const PostTimer&) = delete;
+    PostTimer& operator=(const PostTimer&) = delete;
+
+private:
+    ImageFormat mFormat;
+    int64_t mStart;
+};
@@ -1,49 +1,2560 @@
 // This file was developed by Thomas Müller <thomas94@gmx.net>.
 // It is published under the BSD 3-Clause License within the LICENSE file.
 
+#include <algorithm>
+#include <ctype.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "allocator.h"
+#include "batch.h"
+#include "compress.h"
+#include "inflater.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "stats.h"
+#include "workers.h"
+
+// Route all of stb_image's allocations through libstbi's allocator; see allocator.h.
+#define STBI_MALLOC(size) stbiMalloc(size)
+#define STBI_REALLOC(p, size) stbiRealloc(p, size)
+#define STBI_FREE(p) stbiFree(p)
+
+// stb_image enables its SSE2 JPEG paths by itself, but its NEON paths only on request.
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(STBI_NEON)
+    #define STBI_NEON
+#endif
+
+#ifdef STBI_USE_LIBDEFLATE
+    #include <libdeflate.h>
+
+namespace {
+    // Called by the PNG parser of the copy of stb_image.h that CMakeLists.txt generates in place of
+    // stbi_zlib_decode_malloc_guesssize_headerflag, which it mirrors.
+    char* pngInflate(const char* data, int len, int initialSize, int* outLen, int parseHeader);
+}
+#endif
 
 #define STBI_ASSERT(x)
 #define STBI_NO_STDIO
 #define STBI_FAILURE_USERMSG
+// Keeps ZlibDecode available in builds whose STBI_FORMATS exclude PNG.
+#define STBI_SUPPORT_ZLIB
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-#ifdef _WIN32
-    #define EXPORT __declspec(dllexport)
-#elif __APPLE__
-    #define EXPORT __attribute__((visibility("default")))
+// The same goes for stb_image_write, whose PNG encoder builds its entire output in memory before passing it on.
+#define STBIW_MALLOC(size) stbiMalloc(size)
+#define STBIW_REALLOC(p, size) stbiRealloc(p, size)
+#define STBIW_FREE(p) stbiFree(p)
+
+namespace {
+    // The zlib compression level of the PNG that is being encoded on each thread. See WritePngToMemory.
+    thread_local int pngCompressionLevel = 8;
+
+    // Replaces the compressor of stb_image_write's PNG encoder, which passes the process-wide
+    // stbi_write_png_compression_level rather than the level of the calling thread.
+    unsigned char* compressPng(unsigned char* data, int len, int* outLen, int) {
+        return zlibCompress(data, len, outLen, pngCompressionLevel);
+    }
+}
+
+#define STBIW_ZLIB_COMPRESS compressPng
+#define STBIW_ASSERT(x)
+#define STBI_WRITE_NO_STDIO
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#ifdef _WIN32
+    #define EXPORT __declspec(dllexport)
+#elif __APPLE__
+    #define EXPORT __attribute__((visibility("default")))
+#else
+    #define EXPORT
+#endif
+
+namespace {
+    // The outcome of the last export that was called on each thread. Failure reasons are string literals, so only
+    // pointers to them need to be stored.
+    thread_local Error lastError = ErrorOk;
+    thread_local const char* lastFailureReason = nullptr;
+    // The format of the last image that was decoded on each thread, to which post-processing time is attributed.
+    thread_local ImageFormat lastFormat = ImageFormatOther;
+    // The number of threads on which the load that is in progress on each thread may decode its image. See ScopedThreads.
+    thread_local int decodeThreads = 1;
+
+    bool containsIgnoreCase(const char* str, const char* substr) {
+        for (; *str; ++str) {
+            size_t i = 0;
+            while (substr[i] && tolower((unsigned char)str[i]) == substr[i]) {
+                ++i;
+            }
+
+            if (!substr[i]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // stb_image only reports failures as strings, so we derive error codes from them. The first matching entry wins.
+    Error classifyFailure(const char* reason) {
+        static const struct {
+            const char* substr;
+            Error error;
+        } errors[] = {
+            {"cancelled", ErrorCancelled},
+            {"unable to open", ErrorIo},
+            {"unable to map", ErrorIo},
+            {"file is empty", ErrorIo},
+            {"memory", ErrorOutOfMemory},
+            {"outofmem", ErrorOutOfMemory},
+            {"too large", ErrorTooLarge},
+            {"very large", ErrorTooLarge},
+            {"known type", ErrorUnknownFormat},
+            {"not a gif", ErrorUnknownFormat},
+            {"unsupported", ErrorUnsupported},
+            {"not supported", ErrorUnsupported},
+            {"invalid argument", ErrorInvalidArgument},
+        };
+
+        if (!reason) {
+            return ErrorCorrupt;
+        }
+
+        for (const auto& e : errors) {
+            if (containsIgnoreCase(reason, e.substr)) {
+                return e.error;
+            }
+        }
+
+        return ErrorCorrupt;
+    }
+
+    // Records the outcome of an export on the calling thread, such that it can be queried through LastError and
+    // FailureReason without other threads interfering.
+    template <typename T>
+    T track(T result) {
+        if (result) {
+            lastError = ErrorOk;
+            lastFailureReason = nullptr;
+        } else {
+            lastFailureReason = stbi_failure_reason();
+            lastError = classifyFailure(lastFailureReason);
+        }
+
+        return result;
+    }
+
+#ifdef STBI_USE_LIBDEFLATE
+    struct DecompressorDeleter {
+        void operator()(libdeflate_decompressor* decompressor) const {
+            libdeflate_free_decompressor(decompressor);
+        }
+    };
+
+    // Decompressors hold their Huffman tables, which are too large to set up anew for every stream.
+    libdeflate_decompressor* threadDecompressor() {
+        thread_local std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> decompressor{libdeflate_alloc_decompressor()};
+        return decompressor.get();
+    }
+
+    // Inflates a zlib stream, or a raw deflate stream unless parseHeader is set, into dst.
+    libdeflate_result inflateInto(const char* data, int64_t len, void* dst, int64_t dstLen, bool parseHeader, int64_t* outLen) {
+        libdeflate_decompressor* decompressor = threadDecompressor();
+        if (!decompressor) {
+            return LIBDEFLATE_INSUFFICIENT_SPACE;
+        }
+
+        size_t nBytes = 0;
+        libdeflate_result result = parseHeader ?
+            libdeflate_zlib_decompress(decompressor, data, (size_t)len, dst, (size_t)dstLen, &nBytes) :
+            libdeflate_deflate_decompress(decompressor, data, (size_t)len, dst, (size_t)dstLen, &nBytes);
+
+        *outLen = (int64_t)nBytes;
+        return result;
+    }
+#endif
+
+    // Inflates a zlib stream, or a raw deflate stream unless parseHeader is set, into memory that is allocated by stbiMalloc.
+    // The memory starts out at initialSize bytes and grows until the output fits. Returns null and sets the STBI failure
+    // reason on failure.
+    char* inflate(const char* data, int64_t len, int64_t initialSize, int64_t* outLen, bool parseHeader) {
+#ifdef STBI_USE_LIBDEFLATE
+        // libdeflate cannot resume once it runs out of space, so every attempt starts over with a buffer twice as large.
+        int64_t size = std::max(initialSize, (int64_t)1);
+        for (;;) {
+            char* dst = (char*)stbiMalloc((size_t)size);
+            if (!dst) {
+                stbi__err("outofmem", "Out of memory");
+                return nullptr;
+            }
+
+            libdeflate_result result = inflateInto(data, len, dst, size, parseHeader, outLen);
+            if (result == LIBDEFLATE_SUCCESS) {
+                return dst;
+            }
+
+            stbiFree(dst);
+            if (result != LIBDEFLATE_INSUFFICIENT_SPACE || size > INT64_MAX / 2) {
+                stbi__err("bad zlib", "Corrupt zlib data");
+                return nullptr;
+            }
+
+            size *= 2;
+        }
+#else
+        if (len > INT_MAX || initialSize > INT_MAX) {
+            stbi__err("too large", "Compressed data is too large for stb_image's inflate");
+            return nullptr;
+        }
+
+        int nBytes = 0;
+        char* dst = stbi_zlib_decode_malloc_guesssize_headerflag(data, (int)len, std::max((int)initialSize, 1), &nBytes, parseHeader);
+        *outLen = nBytes;
+        return dst;
+#endif
+    }
+
+#ifdef STBI_USE_LIBDEFLATE
+    char* pngInflate(const char* data, int len, int initialSize, int* outLen, int parseHeader) {
+        int64_t nBytes;
+        char* dst = inflate(data, len, initialSize, &nBytes, parseHeader != 0);
+        if (dst && nBytes > INT_MAX) {
+            stbiFree(dst);
+            stbi__err("too large", "Image is too large to decode");
+            return nullptr;
+        }
+
+        *outLen = (int)nBytes;
+        return dst;
+    }
+#endif
+
+    // Read-only memory mapping of an entire file, such that images can be decoded from files without copying them
+    // into memory first. On failure, data() returns null and the STBI failure reason is set.
+    class MappedFile {
+    public:
+        MappedFile(const char* path) {
+#ifdef _WIN32
+            // Paths are passed as UTF-8 and need to be converted to UTF-16 for the wide Windows API.
+            int nWideChars = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+            if (nWideChars <= 0) {
+                stbi__err("can't open", "Unable to open file");
+                return;
+            }
+
+            wchar_t* widePath = (wchar_t*)malloc(nWideChars * sizeof(wchar_t));
+            if (!widePath) {
+                stbi__err("outofmem", "Out of memory");
+                return;
+            }
+
+            MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath, nWideChars);
+            mFile = CreateFileW(widePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            free(widePath);
+
+            LARGE_INTEGER size;
+            if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size)) {
+                stbi__err("can't open", "Unable to open file");
+                return;
+            }
+
+            // Empty files can not be mapped.
+            if (size.QuadPart == 0) {
+                stbi__err("empty file", "Image file is empty");
+                return;
+            }
+
+            mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mMapping) {
+                stbi__err("can't map", "Unable to map file into memory");
+                return;
+            }
+
+            mData = (const unsigned char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+            if (!mData) {
+                stbi__err("can't map", "Unable to map file into memory");
+                return;
+            }
+
+            mSize = (int64_t)size.QuadPart;
+#else
+            mFile = open(path, O_RDONLY);
+
+            struct stat info;
+            if (mFile == -1 || fstat(mFile, &info) != 0) {
+                stbi__err("can't open", "Unable to open file");
+                return;
+            }
+
+            // Empty files can not be mapped.
+            if (info.st_size == 0) {
+                stbi__err("empty file", "Image file is empty");
+                return;
+            }
+
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+            if (data == MAP_FAILED) {
+                stbi__err("can't map", "Unable to map file into memory");
+                return;
+            }
+
+            mData = (const unsigned char*)data;
+            mSize = (int64_t)info.st_size;
+#endif
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (mData) {
+                UnmapViewOfFile(mData);
+            }
+
+            if (mMapping) {
+                CloseHandle(mMapping);
+            }
+
+            if (mFile != INVALID_HANDLE_VALUE) {
+                CloseHandle(mFile);
+            }
+#else
+            if (mData) {
+                munmap((void*)mData, (size_t)mSize);
+            }
+
+            if (mFile != -1) {
+                close(mFile);
+            }
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const unsigned char* data() const {
+            return mData;
+        }
+
+        int64_t size() const {
+            return mSize;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE mFile = INVALID_HANDLE_VALUE;
+        HANDLE mMapping = nullptr;
+#else
+        int mFile = -1;
+#endif
+        const unsigned char* mData = nullptr;
+        int64_t mSize = 0;
+    };
+
+    // Applies a flip setting to the calling thread for the duration of a single load. Afterwards, the thread goes back to
+    // whatever it followed before, which usually is the global setting of SetFlipVerticallyOnLoad.
+    class ScopedFlip {
+    public:
+        ScopedFlip(bool flip) : mLocal{stbi__vertically_flip_on_load_local}, mSet{stbi__vertically_flip_on_load_set} {
+            stbi_set_flip_vertically_on_load_thread(flip);
+        }
+
+        ~ScopedFlip() {
+            stbi__vertically_flip_on_load_local = mLocal;
+            stbi__vertically_flip_on_load_set = mSet;
+        }
+
+        ScopedFlip(const ScopedFlip&) = delete;
+        ScopedFlip& operator=(const ScopedFlip&) = delete;
+
+    private:
+        int mLocal;
+        int mSet;
+    };
+
+    // Like ScopedFlip, but for the number of threads on which loads on the calling thread may decode a single image.
+    class ScopedThreads {
+    public:
+        ScopedThreads(int nThreads) : mPrevious{decodeThreads} {
+            decodeThreads = nThreads;
+        }
+
+        ~ScopedThreads() {
+            decodeThreads = mPrevious;
+        }
+
+        ScopedThreads(const ScopedThreads&) = delete;
+        ScopedThreads& operator=(const ScopedThreads&) = delete;
+
+    private:
+        int mPrevious;
+    };
+
+    // stb_image takes the length of in-memory data as an int. Larger inputs are fed to it through callbacks instead, from
+    // which it reads in small chunks. Between chunks, the reader checks whether the load was cancelled, in which case it
+    // stops yielding data.
+    class MemoryReader {
+    public:
+        MemoryReader(const unsigned char* data, int64_t len, const volatile int* cancelled = nullptr) : mData{data}, mLen{len}, mCancelled{cancelled} {}
+
+        static const stbi_io_callbacks callbacks;
+
+    private:
+        static int read(void* user, char* data, int size) {
+            MemoryReader* self = (MemoryReader*)user;
+            if (self->mCancelled && *self->mCancelled) {
+                return 0;
+            }
+
+            int64_t n = self->mLen - self->mPos < size ? self->mLen - self->mPos : size;
+            memcpy(data, self->mData + self->mPos, (size_t)n);
+            self->mPos += n;
+            return (int)n;
+        }
+
+        static void skip(void* user, int n) {
+            MemoryReader* self = (MemoryReader*)user;
+            self->mPos += n;
+            if (self->mPos < 0) {
+                self->mPos = 0;
+            } else if (self->mPos > self->mLen) {
+                self->mPos = self->mLen;
+            }
+        }
+
+        static int eof(void* user) {
+            MemoryReader* self = (MemoryReader*)user;
+            return self->mPos >= self->mLen || (self->mCancelled && *self->mCancelled);
+        }
+
+        const unsigned char* mData;
+        int64_t mLen;
+        int64_t mPos = 0;
+        const volatile int* mCancelled;
+    };
+
+    const stbi_io_callbacks MemoryReader::callbacks = {&MemoryReader::read, &MemoryReader::skip, &MemoryReader::eof};
+
+    bool checkLength(int64_t len) {
+        if (len < 0) {
+            stbi__err("negative length", "Invalid argument: negative length");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool infoFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels) {
+        if (!checkLength(len)) {
+            return false;
+        }
+
+        if (len > INT_MAX) {
+            MemoryReader reader{data, len};
+            return stbi_info_from_callbacks(&MemoryReader::callbacks, &reader, w, h, nChannels) == 1;
+        }
+
+        return stbi_info_from_memory(data, (int)len, w, h, nChannels) == 1;
+    }
+
+    bool isHdrFromMemory(const unsigned char* data, int64_t len) {
+        if (len < 0) {
+            return false;
+        }
+
+        if (len > INT_MAX) {
+            MemoryReader reader{data, len};
+            return stbi_is_hdr_from_callbacks(&MemoryReader::callbacks, &reader) == 1;
+        }
+
+        return stbi_is_hdr_from_memory(data, (int)len) == 1;
+    }
+
+    bool is16BitFromMemory(const unsigned char* data, int64_t len) {
+        if (len < 0) {
+            return false;
+        }
+
+        if (len > INT_MAX) {
+            MemoryReader reader{data, len};
+            return stbi_is_16_bit_from_callbacks(&MemoryReader::callbacks, &reader) == 1;
+        }
+
+        return stbi_is_16_bit_from_memory(data, (int)len) == 1;
+    }
+
+    // Probes everything that InfoBatch reports in one go. stbi_info, stbi_is_hdr, and stbi_is_16_bit would each set up a
+    // context of their own and run their format tests from scratch, whereas this runs stb_image's info tests once and then
+    // only the HDR or 16-bit test of the format that the signature of the data names, on the same context.
+    bool probeFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, bool* isHdr, int* bitsPerChannel) {
+        if (!checkLength(len)) {
+            return false;
+        }
+
+        // Restarting the context reads the data from the beginning again, which stbi__rewind only does for the first
+        // buffer of callback contexts.
+        MemoryReader reader{data, len};
+        stbi__context context;
+        auto start = [&] {
+            if (len > INT_MAX) {
+                reader = MemoryReader{data, len};
+                stbi__start_callbacks(&context, (stbi_io_callbacks*)&MemoryReader::callbacks, &reader);
+            } else {
+                stbi__start_mem(&context, data, (int)len);
+            }
+        };
+
+        start();
+        if (!stbi__info_main(&context, w, h, nChannels)) {
+            return false;
+        }
+
+        *isHdr = false;
+        *bitsPerChannel = 8;
+        switch (identifyFormat(data, len)) {
+#ifndef STBI_NO_HDR
+            case ImageFormatHdr:
+                start();
+                *isHdr = stbi__hdr_test(&context) != 0;
+                *bitsPerChannel = *isHdr ? 32 : 8;
+                break;
+#endif
+            case ImageFormatPng:
+            case ImageFormatPsd:
+            case ImageFormatPnm:
+                start();
+                *bitsPerChannel = stbi__is_16_main(&context) ? 16 : 8;
+                break;
+            default:
+                break;
+        }
+
+        return true;
+    }
+
+    // Images below this size decode faster on one thread than it takes to start others.
+    const int64_t minParallelPixels = 1 << 20;
+
+    // Decodes a baseline JPEG with restart markers in bands of MCU rows on several threads. Restart markers reset the
+    // state of the entropy decoder, so each band can be turned into a JPEG of its own: the original headers with the
+    // height patched, followed by the entropy-coded data of the band's restart intervals. Bands are decoded with
+    // context rows above and below, which are discarded afterwards, such that chroma upsampling across band boundaries
+    // produces the same pixels as decoding the entire image at once. stb_image exposes neither its entropy decoder nor
+    // its IDCT, so JPEGs without restart markers, progressive JPEGs, and other formats are not split.
+    class JpegBands {
+    public:
+        // Returns false if the image cannot be split, in which case it should be decoded in one go.
+        bool parse(const unsigned char* data, int64_t len) {
+            mData = data;
+            mLen = len;
+            if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+                return false;
+            }
+
+            int64_t pos = 2;
+            int restartInterval = 0;
+            int hMax = 0, vMax = 0;
+            bool hasFrame = false;
+            for (;;) {
+                // Markers may be preceded by any number of fill bytes.
+                if (pos >= len || data[pos] != 0xFF) {
+                    return false;
+                }
+
+                while (pos < len && data[pos] == 0xFF) {
+                    ++pos;
+                }
+
+                if (pos + 3 > len) {
+                    return false;
+                }
+
+                unsigned char marker = data[pos++];
+                int64_t segmentLen = be16(pos);
+                if (marker == 0xD8 || marker == 0xD9 || (marker >= 0xD0 && marker <= 0xD7) || segmentLen < 2 || pos + segmentLen > len) {
+                    return false;
+                }
+
+                if (marker == 0xC0 || marker == 0xC1) {
+                    if (segmentLen < 8) {
+                        return false;
+                    }
+
+                    mHeightPos = pos + 3;
+                    mHeight = be16(pos + 3);
+                    mWidth = be16(pos + 5);
+                    mNComponents = data[pos + 7];
+                    if (segmentLen < 8 + 3 * mNComponents) {
+                        return false;
+                    }
+
+                    for (int c = 0; c < mNComponents; ++c) {
+                        hMax = std::max(hMax, data[pos + 9 + 3 * c] >> 4);
+                        vMax = std::max(vMax, data[pos + 9 + 3 * c] & 15);
+                    }
+
+                    hasFrame = true;
+                } else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                    // Progressive, lossless, or arithmetic-coded.
+                    return false;
+                } else if (marker == 0xDD) {
+                    if (segmentLen < 4) {
+                        return false;
+                    }
+
+                    restartInterval = be16(pos + 2);
+                } else if (marker == 0xDA) {
+                    // Scans of a subset of the components are followed by further scans, which cannot be split.
+                    if (!hasFrame || restartInterval == 0 || segmentLen < 3 || data[pos + 2] != mNComponents) {
+                        return false;
+                    }
+
+                    mScanPos = pos + segmentLen;
+                    break;
+                }
+
+                pos += segmentLen;
+            }
+
+            if (mWidth == 0 || mHeight == 0 || hMax == 0 || vMax == 0) {
+                return false;
+            }
+
+            // Single-component scans of stb_image consist of 8x8 blocks, regardless of the sampling factors.
+            mMcuWidth = mNComponents == 1 ? 8 : 8 * hMax;
+            mMcuHeight = mNComponents == 1 ? 8 : 8 * vMax;
+            mMcusPerRow = (mWidth + mMcuWidth - 1) / mMcuWidth;
+            mNRows = (mHeight + mMcuHeight - 1) / mMcuHeight;
+            mRestartInterval = restartInterval;
+
+            // Bands can only begin at rows that begin with a restart interval.
+            int a = restartInterval, b = mMcusPerRow;
+            while (b != 0) {
+                int t = a % b;
+                a = b;
+                b = t;
+            }
+
+            mRowsPerSync = restartInterval / a;
+
+            mIntervalBegins.push_back(mScanPos);
+            for (int64_t i = mScanPos; i + 1 < len; ++i) {
+                if (data[i] != 0xFF || data[i + 1] == 0xFF) {
+                    continue;
+                }
+
+                unsigned char marker = data[i + 1];
+                if (marker == 0x00) {
+                    ++i;
+                } else if (marker >= 0xD0 && marker <= 0xD7) {
+                    mIntervalEnds.push_back(i);
+                    mIntervalBegins.push_back(i + 2);
+                    ++i;
+                } else {
+                    // Anything but the end of the image means further scans.
+                    if (marker != 0xD9) {
+                        return false;
+                    }
+
+                    mIntervalEnds.push_back(i);
+                    break;
+                }
+            }
+
+            int64_t nMcus = (int64_t)mMcusPerRow * mNRows;
+            return mIntervalEnds.size() == mIntervalBegins.size() && (int64_t)mIntervalEnds.size() == (nMcus + restartInterval - 1) / restartInterval;
+        }
+
+        // Returns null if any band fails to decode, in which case the image should be decoded in one go to learn why.
+        unsigned char* decode(int nThreads, int nDesiredChannels, int* w, int* h, int* nChannels) {
+            int64_t nSyncs = (mNRows + mRowsPerSync - 1) / mRowsPerSync;
+            int nBands = (int)std::min((int64_t)nThreads, nSyncs);
+            if (nBands < 2) {
+                return nullptr;
+            }
+
+            // The number of channels of the output is only known once it is decoded, so the output is allocated for as many
+            // channels as stb_image is going to produce. The first allocation of this size is served from the target
+            // buffer, if one was set, before any band is decoded on this thread.
+            int n = nDesiredChannels != 0 ? nDesiredChannels : mNComponents == 4 ? 3 : mNComponents;
+            size_t rowBytes = (size_t)mWidth * n;
+            unsigned char* pixels = (unsigned char*)stbiMalloc(rowBytes * mHeight);
+            if (!pixels) {
+                return nullptr;
+            }
+
+            bool flip = stbi__vertically_flip_on_load != 0;
+            std::vector<char> failed(nBands, 0);
+            parallelFor((size_t)nBands, nBands, [&](size_t band) {
+                int64_t r0 = std::min(nSyncs * (int64_t)band / nBands * mRowsPerSync, (int64_t)mNRows);
+                int64_t r1 = std::min(nSyncs * (int64_t)(band + 1) / nBands * mRowsPerSync, (int64_t)mNRows);
+                int64_t d0 = band > 0 ? r0 - mRowsPerSync : 0;
+                int64_t d1 = band + 1 < (size_t)nBands ? std::min(r1 + mRowsPerSync, (int64_t)mNRows) : mNRows;
+
+                int bandW, bandH, bandChannels;
+                unsigned char* bandPixels = decodeRows(d0, d1, n, &bandW, &bandH, &bandChannels);
+                if (!bandPixels) {
+                    failed[band] = 1;
+                    return;
+                }
+
+                int64_t y0 = r0 * mMcuHeight, y1 = std::min(r1 * mMcuHeight, (int64_t)mHeight);
+                for (int64_t y = y0; y < y1; ++y) {
+                    int64_t dstY = flip ? mHeight - 1 - y : y;
+                    memcpy(pixels + dstY * rowBytes, bandPixels + (y - d0 * mMcuHeight) * rowBytes, rowBytes);
+                }
+
+                if (band == 0) {
+                    *nChannels = bandChannels;
+                }
+
+                stbi_image_free(bandPixels);
+            });
+
+            if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+                stbiFree(pixels);
+                return nullptr;
+            }
+
+            *w = mWidth;
+            *h = mHeight;
+            return pixels;
+        }
+
+        int64_t nPixels() const {
+            return (int64_t)mWidth * mHeight;
+        }
+
+    private:
+        int be16(int64_t pos) const {
+            return (mData[pos] << 8) | mData[pos + 1];
+        }
+
+        // Decodes MCU rows [r0, r1) as a JPEG of their own.
+        unsigned char* decodeRows(int64_t r0, int64_t r1, int nDesiredChannels, int* w, int* h, int* nChannels) const {
+            size_t first = (size_t)(r0 * mMcusPerRow / mRestartInterval);
+            size_t last = r1 == mNRows ? mIntervalEnds.size() - 1 : (size_t)(r1 * mMcusPerRow / mRestartInterval) - 1;
+            int64_t height = std::min(r1 * mMcuHeight, (int64_t)mHeight) - r0 * mMcuHeight;
+            int64_t entropyLen = mIntervalEnds[last] - mIntervalBegins[first];
+
+            int64_t len = mScanPos + entropyLen + 2;
+            if (len > INT_MAX) {
+                return nullptr;
+            }
+
+            unsigned char* jpeg = (unsigned char*)stbiMalloc((size_t)len);
+            if (!jpeg) {
+                return nullptr;
+            }
+
+            memcpy(jpeg, mData, (size_t)mScanPos);
+            jpeg[mHeightPos] = (unsigned char)(height >> 8);
+            jpeg[mHeightPos + 1] = (unsigned char)height;
+            memcpy(jpeg + mScanPos, mData + mIntervalBegins[first], (size_t)entropyLen);
+            jpeg[len - 2] = 0xFF;
+            jpeg[len - 1] = 0xD9;
+
+            // Bands are flipped while they are assembled.
+            ScopedFlip flip{false};
+            unsigned char* pixels = stbi_load_from_memory(jpeg, (int)len, w, h, nChannels, nDesiredChannels);
+            stbiFree(jpeg);
+            return pixels;
+        }
+
+        const unsigned char* mData = nullptr;
+        int64_t mLen = 0;
+
+        int mWidth = 0, mHeight = 0, mNComponents = 0;
+        int64_t mHeightPos = 0;
+        int64_t mScanPos = 0;
+
+        int mMcuWidth = 0, mMcuHeight = 0, mMcusPerRow = 0, mNRows = 0;
+        int mRestartInterval = 0;
+        int mRowsPerSync = 0;
+
+        std::vector<int64_t> mIntervalBegins;
+        std::vector<int64_t> mIntervalEnds;
+    };
+
+    // Loads an image with 8 or 16 bits per channel as unsigned integers, or with 32 bits per channel as floats. Loads that
+    // can be cancelled read through callbacks, such that the flag is checked whenever stb_image refills its input buffer.
+    void* decodeFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels, int bitsPerChannel, const volatile int* cancelled = nullptr) {
+        if (!checkLength(len)) {
+            return nullptr;
+        }
+
+        if (len > INT_MAX || cancelled) {
+            MemoryReader reader{data, len, cancelled};
+            switch (bitsPerChannel) {
+                case 8: return stbi_load_from_callbacks(&MemoryReader::callbacks, &reader, w, h, nChannels, nDesiredChannels);
+                case 16: return stbi_load_16_from_callbacks(&MemoryReader::callbacks, &reader, w, h, nChannels, nDesiredChannels);
+                case 32: return stbi_loadf_from_callbacks(&MemoryReader::callbacks, &reader, w, h, nChannels, nDesiredChannels);
+            }
+        } else {
+            if (decodeThreads > 1 && bitsPerChannel == 8) {
+                JpegBands bands;
+                if (bands.parse(data, len) && bands.nPixels() >= minParallelPixels) {
+                    void* pixels = bands.decode(decodeThreads, nDesiredChannels, w, h, nChannels);
+                    if (pixels) {
+                        return pixels;
+                    }
+                }
+            }
+
+            switch (bitsPerChannel) {
+                case 8: return stbi_load_from_memory(data, (int)len, w, h, nChannels, nDesiredChannels);
+                case 16: return stbi_load_16_from_memory(data, (int)len, w, h, nChannels, nDesiredChannels);
+                case 32: return stbi_loadf_from_memory(data, (int)len, w, h, nChannels, nDesiredChannels);
+            }
+        }
+
+        stbi__err("bad bits per channel", "Unsupported number of bits per channel");
+        return nullptr;
+    }
+
+    // When statistics are enabled, the header is parsed separately ahead of the decode to measure its share.
+    void* loadFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels, int bitsPerChannel, const volatile int* cancelled = nullptr) {
+        if (!statsEnabled()) {
+            return decodeFromMemory(data, len, w, h, nChannels, nDesiredChannels, bitsPerChannel, cancelled);
+        }
+
+        lastFormat = len > 0 ? identifyFormat(data, len) : ImageFormatOther;
+
+        int64_t start = nowNanoseconds();
+        infoFromMemory(data, len, w, h, nChannels);
+        recordHeader(lastFormat, nowNanoseconds() - start);
+
+        start = nowNanoseconds();
+        void* pixels = decodeFromMemory(data, len, w, h, nChannels, nDesiredChannels, bitsPerChannel, cancelled);
+        int64_t nBytesOut = pixels ? (int64_t)*w * *h * (nDesiredChannels == 0 ? *nChannels : nDesiredChannels) * (bitsPerChannel / 8) : 0;
+        recordDecode(lastFormat, pixels != nullptr, len, nBytesOut, nowNanoseconds() - start);
+        return pixels;
+    }
+
+    // A negative dstLen means that the caller already made sure that dst is large enough.
+    bool checkBufferSize(int64_t dstLen, uint64_t size) {
+        if (dstLen >= 0 && (uint64_t)dstLen < size) {
+            stbi__err("bad buffer size", "Invalid argument: destination buffer is too small");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Exports take the length of dst from callers that cannot opt out of the check, so negative lengths must not disable it.
+    int64_t exportedLen(int64_t dstLen) {
+        return std::max(dstLen, (int64_t)0);
+    }
+
+    bool loadIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, int bitsPerChannel, void* dst, int* w, int* h, int* nChannels, int64_t dstLen = -1) {
+        // The size of dst is implied by the image's metadata. We request it to learn the size of the allocation that
+        // stb_image is going to make for its output.
+        if (!infoFromMemory(data, len, w, h, nChannels)) {
+            return false;
+        }
+
+        if (nDesiredChannels == 0) {
+            nDesiredChannels = *nChannels;
+        }
+
+        if (!checkBufferSize(dstLen, ((uint64_t)*w * *h) * nDesiredChannels * (bitsPerChannel / 8))) {
+            return false;
+        }
+
+        setTargetBuffer(dst, ((size_t)*w * *h) * nDesiredChannels * (bitsPerChannel / 8));
+        void* result = loadFromMemory(data, len, w, h, nChannels, nDesiredChannels, bitsPerChannel);
+        clearTargetBuffer();
+
+        if (!result) {
+            return false;
+        }
+
+        // Some decoders allocate intermediate buffers of the same size as the output, in which case the output may have
+        // ended up in a regular allocation. Fall back to copying in that case.
+        if (result != dst) {
+            memcpy(dst, result, ((size_t)*w * *h) * nDesiredChannels * (bitsPerChannel / 8));
+            stbi_image_free(result);
+        }
+
+        return true;
+    }
+
+    bool checkRegion(int x, int y, int w, int h, int width, int height) {
+        if (x < 0 || y < 0 || w <= 0 || h <= 0 || x > width - w || y > height - h) {
+            stbi__err("bad region", "Invalid argument: region exceeds the image bounds");
+            return false;
+        }
+
+        return true;
+    }
+
+    // stb_image has no way of decoding a subset of scanlines, so the full frame is decoded into a scratch buffer from
+    // which the region is copied. The scratch buffer is returned to the thread's arena right away, such that repeated
+    // region loads reuse it rather than allocating a full frame each time.
+    bool loadRegionIntoBuffer(const unsigned char* data, int64_t len, int x, int y, int w, int h, int nDesiredChannels, unsigned char* dst, int* nChannels, int64_t dstLen = -1) {
+        int width, height;
+        if (!infoFromMemory(data, len, &width, &height, nChannels) || !checkRegion(x, y, w, h, width, height)) {
+            return false;
+        }
+
+        size_t n = nDesiredChannels == 0 ? *nChannels : nDesiredChannels;
+        if (!checkBufferSize(dstLen, ((uint64_t)w * h) * n)) {
+            return false;
+        }
+
+        if (w == width && h == height) {
+            return loadIntoBuffer(data, len, nDesiredChannels, 8, dst, &width, &height, nChannels);
+        }
+
+        unsigned char* frame = (unsigned char*)loadFromMemory(data, len, &width, &height, nChannels, nDesiredChannels, 8);
+        if (!frame) {
+            return false;
+        }
+
+        size_t srcStride = (size_t)width * n;
+        size_t dstStride = (size_t)w * n;
+        const unsigned char* src = frame + (size_t)y * srcStride + (size_t)x * n;
+        for (int i = 0; i < h; ++i) {
+            memcpy(dst + i * dstStride, src + i * srcStride, dstStride);
+        }
+
+        stbi_image_free(frame);
+        return true;
+    }
+
+    unsigned char* loadRegion(const unsigned char* data, int64_t len, int x, int y, int w, int h, int* nChannels, int nDesiredChannels) {
+        int width, height;
+        if (!infoFromMemory(data, len, &width, &height, nChannels) || !checkRegion(x, y, w, h, width, height)) {
+            return nullptr;
+        }
+
+        size_t n = nDesiredChannels == 0 ? *nChannels : nDesiredChannels;
+        unsigned char* pixels = (unsigned char*)stbiMalloc(((size_t)w * h) * n);
+        if (!pixels) {
+            stbi__err("outofmem", "Out of memory");
+            return nullptr;
+        }
+
+        if (!loadRegionIntoBuffer(data, len, x, y, w, h, nDesiredChannels, pixels, nChannels)) {
+            stbiFree(pixels);
+            return nullptr;
+        }
+
+        return pixels;
+    }
+
+    int scaledSize(int size, int scaleDenominator) {
+        return (int)(((int64_t)size + scaleDenominator - 1) / scaleDenominator);
+    }
+
+    // Averages each block of scaleDenominator x scaleDenominator pixels into one pixel. Blocks at the right and bottom
+    // edges may be partial, in which case only the pixels within the image are averaged.
+    bool boxFilter(const unsigned char* src, int width, int height, int n, int scaleDenominator, unsigned char* dst) {
+        int dstWidth = scaledSize(width, scaleDenominator);
+        int dstHeight = scaledSize(height, scaleDenominator);
+        size_t dstStride = (size_t)dstWidth * n;
+
+        uint32_t* sums = (uint32_t*)stbiMalloc(dstStride * sizeof(uint32_t));
+        if (!sums) {
+            stbi__err("outofmem", "Out of memory");
+            return false;
+        }
+
+        for (int dy = 0; dy < dstHeight; ++dy) {
+            int y0 = dy * scaleDenominator;
+            int y1 = y0 + scaleDenominator < height ? y0 + scaleDenominator : height;
+            memset(sums, 0, dstStride * sizeof(uint32_t));
+
+            for (int y = y0; y < y1; ++y) {
+                const unsigned char* row = src + (size_t)y * width * n;
+                for (int x = 0; x < width; ++x) {
+                    uint32_t* sum = sums + (size_t)(x / scaleDenominator) * n;
+                    for (int c = 0; c < n; ++c) {
+                        sum[c] += row[(size_t)x * n + c];
+                    }
+                }
+            }
+
+            unsigned char* dstRow = dst + dy * dstStride;
+            for (int dx = 0; dx < dstWidth; ++dx) {
+                int x0 = dx * scaleDenominator;
+                int x1 = x0 + scaleDenominator < width ? x0 + scaleDenominator : width;
+                uint32_t count = (uint32_t)((x1 - x0) * (y1 - y0));
+                for (int c = 0; c < n; ++c) {
+                    dstRow[(size_t)dx * n + c] = (unsigned char)((sums[(size_t)dx * n + c] + count / 2) / count);
+                }
+            }
+        }
+
+        stbiFree(sums);
+        return true;
+    }
+
+    // stb_image can neither scale its JPEG IDCT nor emit scanlines incrementally, so the full frame is decoded into a
+    // scratch allocation, which is box filtered into dst and then returned to the thread's arena.
+    bool loadScaledIntoBuffer(const unsigned char* data, int64_t len, int scaleDenominator, int nDesiredChannels, unsigned char* dst, int* w, int* h, int* nChannels, int64_t dstLen = -1) {
+        if (scaleDenominator < 1) {
+            stbi__err("bad scale", "Invalid argument: scale denominator must be positive");
+            return false;
+        }
+
+        if (scaleDenominator == 1) {
+            return loadIntoBuffer(data, len, nDesiredChannels, 8, dst, w, h, nChannels, dstLen);
+        }
+
+        int width, height;
+        if (dstLen >= 0) {
+            if (!infoFromMemory(data, len, &width, &height, nChannels)) {
+                return false;
+            }
+
+            size_t n = nDesiredChannels == 0 ? *nChannels : nDesiredChannels;
+            if (!checkBufferSize(dstLen, ((uint64_t)scaledSize(width, scaleDenominator) * scaledSize(height, scaleDenominator)) * n)) {
+                return false;
+            }
+        }
+
+        unsigned char* frame = (unsigned char*)loadFromMemory(data, len, &width, &height, nChannels, nDesiredChannels, 8);
+        if (!frame) {
+            return false;
+        }
+
+        bool result;
+        {
+            PostTimer timer{lastFormat};
+            result = boxFilter(frame, width, height, nDesiredChannels == 0 ? *nChannels : nDesiredChannels, scaleDenominator, dst);
+        }
+
+        stbi_image_free(frame);
+
+        *w = scaledSize(width, scaleDenominator);
+        *h = scaledSize(height, scaleDenominator);
+        return result;
+    }
+
+    unsigned char* loadScaled(const unsigned char* data, int64_t len, int scaleDenominator, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        if (scaleDenominator < 1) {
+            stbi__err("bad scale", "Invalid argument: scale denominator must be positive");
+            return nullptr;
+        }
+
+        int width, height;
+        if (!infoFromMemory(data, len, &width, &height, nChannels)) {
+            return nullptr;
+        }
+
+        size_t n = nDesiredChannels == 0 ? *nChannels : nDesiredChannels;
+        unsigned char* pixels = (unsigned char*)stbiMalloc(((size_t)scaledSize(width, scaleDenominator) * scaledSize(height, scaleDenominator)) * n);
+        if (!pixels) {
+            stbi__err("outofmem", "Out of memory");
+            return nullptr;
+        }
+
+        if (!loadScaledIntoBuffer(data, len, scaleDenominator, nDesiredChannels, pixels, w, h, nChannels)) {
+            stbiFree(pixels);
+            return nullptr;
+        }
+
+        return pixels;
+    }
+
+    // Decodes a non-interlaced PNG row by row into the same pixels that stb_image produces with 8 bits per channel, but
+    // without ever holding the entire image: the Inflater keeps a 32 KiB window of the image data, and unfiltering only
+    // refers back to the previous row. stb_image inflates the entire image data into one buffer, so it cannot do this.
+    // Interlaced PNGs, whose passes each span the entire image, Apple's CgBI PNGs, and PNGs that stb_image rejects while
+    // parsing their headers are not streamed, such that they are decoded in one go and fail with stb_image's reasons.
+    class PngRows {
+    public:
+        // Returns false if the image cannot be streamed, in which case it should be decoded in one go.
+        bool parse(const unsigned char* data, int64_t len, int nDesiredChannels) {
+            static const unsigned char SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+            if (len < 8 || memcmp(data, SIGNATURE, 8) != 0 || nDesiredChannels < 0 || nDesiredChannels > 4) {
+                return false;
+            }
+
+            mData = data;
+            mLen = len;
+
+            bool hasHeader = false;
+            for (int64_t pos = 8;;) {
+                if (pos + 12 > len) {
+                    return false;
+                }
+
+                uint32_t chunkLen = be32(pos), type = be32(pos + 4);
+                if (chunkLen > INT32_MAX || pos + 12 + chunkLen > len || (!hasHeader && type != chunkType("IHDR"))) {
+                    return false;
+                }
+
+                const unsigned char* chunk = data + pos + 8;
+                if (type == chunkType("IHDR")) {
+                    if (hasHeader || chunkLen != 13 || !parseHeader(pos + 8)) {
+                        return false;
+                    }
+
+                    hasHeader = true;
+                } else if (type == chunkType("PLTE")) {
+                    if (chunkLen == 0 || chunkLen > 768 || chunkLen % 3 != 0 || mNPaletteEntries > 0) {
+                        return false;
+                    }
+
+                    mNPaletteEntries = (int)chunkLen / 3;
+                    for (int i = 0; i < mNPaletteEntries; ++i) {
+                        memcpy(mPalette + i * 4, chunk + i * 3, 3);
+                        mPalette[i * 4 + 3] = 255;
+                    }
+                } else if (type == chunkType("tRNS")) {
+                    if (mHasTransparency) {
+                        return false;
+                    }
+
+                    if (mColorType == 3) {
+                        if (mNPaletteEntries == 0 || chunkLen > (uint32_t)mNPaletteEntries) {
+                            return false;
+                        }
+
+                        for (uint32_t i = 0; i < chunkLen; ++i) {
+                            mPalette[i * 4 + 3] = chunk[i];
+                        }
+                    } else {
+                        // Greyscale and RGB images specify a colour key, whereas images with alpha cannot have one.
+                        if ((mColorType & 4) || chunkLen != (uint32_t)mNSamples * 2) {
+                            return false;
+                        }
+
+                        // Like stb_image, only the lower byte of keys of 8-bit images is scaled up to 8 bits and compared.
+                        for (int c = 0; c < mNSamples; ++c) {
+                            int key = (chunk[c * 2] << 8) | chunk[c * 2 + 1];
+                            mKey[c] = (uint16_t)(mDepth == 16 ? key : (key & 255) * depthScale());
+                        }
+                    }
+
+                    mHasTransparency = true;
+                } else if (type == chunkType("CgBI")) {
+                    return false;
+                } else if (type == chunkType("IDAT")) {
+                    if (mColorType == 3 && mNPaletteEntries == 0) {
+                        return false;
+                    }
+
+                    mChunkPos = pos;
+                    break;
+                } else if (type == chunkType("IEND") || (chunk[-4] & 32) == 0) {
+                    // Without image data, or with a critical chunk that stb_image does not know.
+                    return false;
+                }
+
+                pos += 12 + chunkLen;
+            }
+
+            if (mColorType == 3) {
+                mNChannels = mHasTransparency ? 4 : 3;
+            } else {
+                mNChannels = mNSamples + (mHasTransparency ? 1 : 0);
+            }
+
+            mNOutChannels = nDesiredChannels == 0 ? mNChannels : nDesiredChannels;
+
+            int bitsPerPixel = mDepth * mNSamples;
+            mRowBytes = ((size_t)mWidth * bitsPerPixel + 7) / 8;
+            mFilterOffset = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+            mRow.assign(mRowBytes + 1, 0);
+            mPrevRow.assign(mRowBytes + 1, 0);
+            mSamples.resize((size_t)mWidth * 4);
+            mInflater.reset(new Inflater{&PngRows::nextChunk, this, true});
+            return true;
+        }
+
+        int width() const {
+            return mWidth;
+        }
+
+        int height() const {
+            return mHeight;
+        }
+
+        // The number of channels that stb_image reports for the image, regardless of the number of desired channels.
+        int nChannels() const {
+            return mNChannels;
+        }
+
+        int nOutChannels() const {
+            return mNOutChannels;
+        }
+
+        // Decodes the next row into dst, which must hold width() * nOutChannels() bytes. Returns false and sets the STBI
+        // failure reason if the image data is corrupt.
+        bool nextRow(unsigned char* dst) {
+            if (!mInflater->read(mRow.data(), mRow.size())) {
+                stbi__err(mInflater->error(), "Corrupt PNG");
+                return false;
+            }
+
+            if (!unfilter()) {
+                stbi__err("invalid filter", "Corrupt PNG");
+                return false;
+            }
+
+            expand();
+            if (mDepth == 16) {
+                convert(dst, 0xFFFF, 8);
+            } else {
+                convert(dst, 0xFF, 0);
+            }
+
+            std::swap(mRow, mPrevRow);
+            return true;
+        }
+
+    private:
+        static uint32_t chunkType(const char* name) {
+            return ((uint32_t)name[0] << 24) | ((uint32_t)name[1] << 16) | ((uint32_t)name[2] << 8) | (uint32_t)name[3];
+        }
+
+        uint32_t be32(int64_t pos) const {
+            return ((uint32_t)mData[pos] << 24) | ((uint32_t)mData[pos + 1] << 16) | ((uint32_t)mData[pos + 2] << 8) | (uint32_t)mData[pos + 3];
+        }
+
+        // Scales samples of less than 8 bits to the full range of greyscale values. Palette indices are not scaled.
+        int depthScale() const {
+            static const int SCALES[9] = {0, 0xFF, 0x55, 0, 0x11, 0, 0, 0, 0x01};
+            return mColorType == 0 && mDepth < 8 ? SCALES[mDepth] : 1;
+        }
+
+        bool parseHeader(int64_t pos) {
+            mWidth = (int)std::min(be32(pos), (uint32_t)INT_MAX);
+            mHeight = (int)std::min(be32(pos + 4), (uint32_t)INT_MAX);
+            mDepth = mData[pos + 8];
+            mColorType = mData[pos + 9];
+
+            // Compression, filter method, and interlacing.
+            if (mData[pos + 10] != 0 || mData[pos + 11] != 0 || mData[pos + 12] != 0) {
+                return false;
+            }
+
+            // stb_image's limit on either dimension.
+            if (mWidth == 0 || mHeight == 0 || mWidth > (1 << 24) || mHeight > (1 << 24)) {
+                return false;
+            }
+
+            switch (mColorType) {
+                case 0: mNSamples = 1; return mDepth == 1 || mDepth == 2 || mDepth == 4 || mDepth == 8 || mDepth == 16;
+                case 2: mNSamples = 3; return mDepth == 8 || mDepth == 16;
+                case 3: mNSamples = 1; return mDepth == 1 || mDepth == 2 || mDepth == 4 || mDepth == 8;
+                case 4: mNSamples = 2; return mDepth == 8 || mDepth == 16;
+                case 6: mNSamples = 4; return mDepth == 8 || mDepth == 16;
+                default: return false;
+            }
+        }
+
+        // Supplies the Inflater with the image data of consecutive IDAT chunks.
+        static bool nextChunk(void* user, const unsigned char** data, size_t* len) {
+            PngRows* self = (PngRows*)user;
+            int64_t pos = self->mChunkPos;
+            if (pos + 12 > self->mLen || self->be32(pos + 4) != chunkType("IDAT")) {
+                return false;
+            }
+
+            uint32_t chunkLen = self->be32(pos);
+            if (chunkLen > INT32_MAX || pos + 12 + chunkLen > self->mLen) {
+                return false;
+            }
+
+            *data = self->mData + pos + 8;
+            *len = chunkLen;
+            self->mChunkPos = pos + 12 + chunkLen;
+            return true;
+        }
+
+        // Undoes the filter of mRow, whose first byte selects it, with respect to mPrevRow, which is zero for the first row.
+        bool unfilter() {
+            unsigned char* row = mRow.data() + 1;
+            const unsigned char* prev = mPrevRow.data() + 1;
+            size_t n = mRowBytes, o = mFilterOffset;
+            switch (mRow[0]) {
+                case 0:
+                    break;
+                case 1:
+                    for (size_t i = o; i < n; ++i) {
+                        row[i] = (unsigned char)(row[i] + row[i - o]);
+                    }
+
+                    break;
+                case 2:
+                    for (size_t i = 0; i < n; ++i) {
+                        row[i] = (unsigned char)(row[i] + prev[i]);
+                    }
+
+                    break;
+                case 3:
+                    for (size_t i = 0; i < n; ++i) {
+                        int left = i >= o ? row[i - o] : 0;
+                        row[i] = (unsigned char)(row[i] + ((left + prev[i]) >> 1));
+                    }
+
+                    break;
+                case 4:
+                    for (size_t i = 0; i < n; ++i) {
+                        int a = i >= o ? row[i - o] : 0, b = prev[i], c = i >= o ? prev[i - o] : 0;
+                        int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+                        row[i] = (unsigned char)(row[i] + (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+                    }
+
+                    break;
+                default:
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Expands the unfiltered row into mNChannels samples per pixel, resolving palette indices and colour keys.
+        void expand() {
+            const unsigned char* row = mRow.data() + 1;
+            uint16_t* out = mSamples.data();
+            int scale = depthScale();
+            for (int x = 0; x < mWidth; ++x) {
+                uint16_t v[4];
+                for (int c = 0; c < mNSamples; ++c) {
+                    size_t i = (size_t)x * mNSamples + c;
+                    if (mDepth == 16) {
+                        v[c] = (uint16_t)((row[i * 2] << 8) | row[i * 2 + 1]);
+                    } else if (mDepth == 8) {
+                        v[c] = row[i];
+                    } else {
+                        size_t bit = i * mDepth;
+                        v[c] = (uint16_t)(((row[bit / 8] >> (8 - mDepth - bit % 8)) & ((1 << mDepth) - 1)) * scale);
+                    }
+                }
+
+                if (mColorType == 3) {
+                    const unsigned char* entry = mPalette + v[0] * 4;
+                    for (int c = 0; c < mNChannels; ++c) {
+                        *out++ = entry[c];
+                    }
+
+                    continue;
+                }
+
+                bool keyed = mHasTransparency;
+                for (int c = 0; c < mNSamples; ++c) {
+                    keyed = keyed && v[c] == mKey[c];
+                    *out++ = v[c];
+                }
+
+                if (mHasTransparency) {
+                    *out++ = (uint16_t)(keyed ? 0 : mDepth == 16 ? 0xFFFF : 0xFF);
+                }
+            }
+        }
+
+        // Converts mSamples to the desired number of channels like stb_image's stbi__convert_format, at the bit depth of
+        // the image, and then reduces them to 8 bits by dropping the lower 8 bits of 16-bit samples, as stb_image does.
+        void convert(unsigned char* dst, unsigned maxValue, int shift) {
+            const uint16_t* src = mSamples.data();
+            int from = mNChannels, to = mNOutChannels;
+            for (int x = 0; x < mWidth; ++x, src += from, dst += to) {
+                unsigned v[4] = {};
+                for (int c = 0; c < from; ++c) {
+                    v[c] = src[c];
+                }
+
+                unsigned out[4];
+                unsigned alpha = from == 2 ? v[1] : from == 4 ? v[3] : maxValue;
+                if (from == to) {
+                    memcpy(out, v, sizeof(out));
+                } else if (to <= 2) {
+                    out[0] = from >= 3 ? (v[0] * 77 + v[1] * 150 + v[2] * 29) >> 8 : v[0];
+                    out[1] = alpha;
+                } else if (from >= 3) {
+                    out[0] = v[0];
+                    out[1] = v[1];
+                    out[2] = v[2];
+                    out[3] = alpha;
+                } else {
+                    out[0] = out[1] = out[2] = v[0];
+                    out[3] = alpha;
+                }
+
+                for (int c = 0; c < to; ++c) {
+                    dst[c] = (unsigned char)(out[c] >> shift);
+                }
+            }
+        }
+
+        const unsigned char* mData = nullptr;
+        int64_t mLen = 0;
+        // The next chunk of image data.
+        int64_t mChunkPos = 0;
+
+        int mWidth = 0, mHeight = 0;
+        int mDepth = 0, mColorType = 0;
+        // The number of samples per pixel in the image data, which are palette indices for palette images.
+        int mNSamples = 0;
+        int mNChannels = 0, mNOutChannels = 0;
+
+        unsigned char mPalette[256 * 4] = {};
+        int mNPaletteEntries = 0;
+        bool mHasTransparency = false;
+        uint16_t mKey[3] = {};
+
+        size_t mRowBytes = 0;
+        // The distance in bytes to the corresponding byte of the pixel to the left, which filters refer to.
+        size_t mFilterOffset = 0;
+        // Filter type followed by the filtered bytes of the row.
+        std::vector<unsigned char> mRow, mPrevRow;
+        std::vector<uint16_t> mSamples;
+
+        std::unique_ptr<Inflater> mInflater;
+    };
+}
+
+// Per-call load options. Unlike SetFlipVerticallyOnLoad, they do not affect loads on other threads.
+struct LoadOptions {
+    int nDesiredChannels;
+    int flipVertically;
+    // 8 or 16 for unsigned integer channels, or 32 for float channels. 0 is treated like 8.
+    int bitsPerChannel;
+    // A ChannelOrder. Anything but RGBA requires 8 bits per channel.
+    int channelOrder;
+    // Nonzero to multiply the colour channels by alpha. Requires 8 bits per channel.
+    int premultiplyAlpha;
+    // The number of threads on which to decode and convert the image. Values below 2 use only the calling thread.
+    int nThreads;
+};
+
+namespace {
+    bool checkConversion(const LoadOptions* options) {
+        if (options->channelOrder < ChannelOrderRgba || options->channelOrder > ChannelOrderArgb) {
+            stbi__err("bad channel order", "Invalid argument: unknown channel order");
+            return false;
+        }
+
+        bool converts = options->channelOrder != ChannelOrderRgba || options->premultiplyAlpha != 0;
+        if (converts && options->bitsPerChannel != 0 && options->bitsPerChannel != 8) {
+            stbi__err("bad bits per channel", "Unsupported number of bits per channel for channel conversion");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Runs as a single pass over the decoded pixels, so callers need not swizzle or premultiply them afterwards.
+    void convert(void* pixels, int w, int h, int nChannels, const LoadOptions* options) {
+        if (options->channelOrder != ChannelOrderRgba || options->premultiplyAlpha != 0) {
+            PostTimer timer{lastFormat};
+            size_t nPixels = (size_t)w * h;
+            int nBands = nPixels >= (size_t)minParallelPixels ? std::max(options->nThreads, 1) : 1;
+            parallelFor((size_t)nBands, nBands, [&](size_t band) {
+                size_t begin = nPixels * band / nBands, end = nPixels * (band + 1) / nBands;
+                convertChannels((unsigned char*)pixels + begin * nChannels, end - begin, nChannels, (ChannelOrder)options->channelOrder, options->premultiplyAlpha != 0);
+            });
+        }
+    }
+
+    // Stores row y of the image rowStride bytes after row y - 1, or before it when flipping vertically, such that the image
+    // can be decoded into buffers whose row pitch is aligned for the GPU. Unless the rows are packed, the image is decoded
+    // and converted in scratch memory first and then copied row by row, such that every byte of dst is written exactly
+    // once. This matters for write-combined upload memory, from which reading back is slow.
+    bool loadIntoStridedBuffer(const unsigned char* data, int64_t len, const LoadOptions* options, unsigned char* dst, int64_t dstLen, int64_t rowStride) {
+        int bitsPerChannel = options->bitsPerChannel == 0 ? 8 : options->bitsPerChannel;
+        ScopedThreads threads{options->nThreads};
+        int w, h, nChannels;
+        if (!infoFromMemory(data, len, &w, &h, &nChannels)) {
+            return false;
+        }
+
+        int n = options->nDesiredChannels == 0 ? nChannels : options->nDesiredChannels;
+        int64_t rowBytes = (int64_t)w * n * (bitsPerChannel / 8);
+        if (rowStride == 0) {
+            rowStride = rowBytes;
+        }
+
+        if (rowStride < rowBytes) {
+            stbi__err("bad stride", "Invalid argument: row stride is smaller than a row of pixels");
+            return false;
+        }
+
+        if (dstLen < (h - 1) * rowStride + rowBytes) {
+            stbi__err("bad buffer size", "Invalid argument: destination buffer is too small");
+            return false;
+        }
+
+        if (rowStride == rowBytes) {
+            ScopedFlip flip{options->flipVertically != 0};
+            if (!loadIntoBuffer(data, len, options->nDesiredChannels, bitsPerChannel, dst, &w, &h, &nChannels)) {
+                return false;
+            }
+
+            convert(dst, w, h, n, options);
+            return true;
+        }
+
+        // Flipping while copying is free, whereas stb_image would flip in a separate pass.
+        ScopedFlip flip{false};
+        unsigned char* pixels = (unsigned char*)loadFromMemory(data, len, &w, &h, &nChannels, options->nDesiredChannels, bitsPerChannel);
+        if (!pixels) {
+            return false;
+        }
+
+        convert(pixels, w, h, n, options);
+        for (int y = 0; y < h; ++y) {
+            int row = options->flipVertically ? h - 1 - y : y;
+            memcpy(dst + row * rowStride, pixels + y * rowBytes, (size_t)rowBytes);
+        }
+
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    // The kernels of stb_image's JPEG IDCT and YCbCr conversion.
+    const char* jpegKernel() {
+#if defined(STBI_NO_JPEG)
+        return "none";
+#elif defined(STBI_SSE2)
+        return stbi__sse2_available() ? "sse2" : "scalar";
+#elif defined(STBI_NEON)
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+}
+
+// Mirrored by StbiPlanarFormat in stbi-sharp.cs.
+enum PlanarFormat : int {
+    PlanarUint8 = 0,
+    // 32-bit floats, of which each is v * scale[c] + bias[c] for the 8-bit value v of channel c.
+    PlanarFloat = 1,
+};
+
+// Planar output stores all values of channel c, row by row, before those of channel c + 1, as expected by tensors in
+// CHW layout. Mirrored by StbiPlanarOptions in stbi-sharp.cs.
+struct PlanarOptions {
+    int format;
+    float scale[4];
+    float bias[4];
+};
+
+namespace {
+    // stb_image converts colours into interleaved pixels without a hook to redirect its stores, so the image is decoded
+    // into scratch memory, where it is still in cache when it is split into planes in a single vectorized pass.
+    bool loadPlanarIntoBuffer(const unsigned char* data, int64_t len, const LoadOptions* options, const PlanarOptions* planar, void* dst, int64_t dstLen, int* w, int* h, int* nChannels) {
+        if (planar->format != PlanarUint8 && planar->format != PlanarFloat) {
+            stbi__err("bad planar format", "Invalid argument: unknown planar format");
+            return false;
+        }
+
+        if (options->bitsPerChannel != 0 && options->bitsPerChannel != 8) {
+            stbi__err("bad bits per channel", "Unsupported number of bits per channel for planar output");
+            return false;
+        }
+
+        if (!infoFromMemory(data, len, w, h, nChannels)) {
+            return false;
+        }
+
+        int n = options->nDesiredChannels == 0 ? *nChannels : options->nDesiredChannels;
+        size_t nPixels = (size_t)*w * *h;
+        size_t valueSize = planar->format == PlanarFloat ? sizeof(float) : 1;
+        if ((uint64_t)dstLen < nPixels * n * valueSize) {
+            stbi__err("bad buffer size", "Invalid argument: destination buffer is too small");
+            return false;
+        }
+
+        ScopedFlip flip{options->flipVertically != 0};
+        ScopedThreads threads{options->nThreads};
+        unsigned char* pixels = (unsigned char*)loadFromMemory(data, len, w, h, nChannels, options->nDesiredChannels, 8);
+        if (!pixels) {
+            return false;
+        }
+
+        convert(pixels, *w, *h, n, options);
+        {
+            PostTimer timer{lastFormat};
+            if (planar->format == PlanarFloat) {
+                deinterleaveToFloat(pixels, nPixels, n, planar->scale, planar->bias, (float*)dst);
+            } else {
+                deinterleave(pixels, nPixels, n, (unsigned char*)dst);
+            }
+        }
+
+        stbi_image_free(pixels);
+        return true;
+    }
+}
+
+// Describes one level of a mip chain within the buffer that holds the entire chain. Mirrored by StbiMipLevel in stbi-sharp.cs.
+struct MipLevel {
+    // In bytes from the beginning of the buffer.
+    int64_t offset;
+    int width;
+    int height;
+};
+
+namespace {
+    // Levels are stored one after another, starting with the full-size image, and each level is half the size of the
+    // previous one, rounded down, until both dimensions are 1 or maxLevels levels are reached. Returns the total size.
+    int64_t mipChainLayout(int w, int h, int nChannels, int maxLevels, MipLevel* levels, int* nLevels) {
+        int64_t offset = 0;
+        int i = 0;
+        for (; i < maxLevels; ++i) {
+            levels[i] = {offset, w, h};
+            offset += (int64_t)w * h * nChannels;
+            if (w == 1 && h == 1) {
+                ++i;
+                break;
+            }
+
+            w = w / 2 > 0 ? w / 2 : 1;
+            h = h / 2 > 0 ? h / 2 : 1;
+        }
+
+        *nLevels = i;
+        return offset;
+    }
+
+    // The full-size image is decoded straight into dst, after which every level is filtered from the previous one while
+    // the latter is still in cache.
+    bool loadMipChainIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, bool srgb, int maxLevels, unsigned char* dst, int64_t dstLen, MipLevel* levels, int* nLevels, int* nChannels) {
+        if (maxLevels < 1) {
+            stbi__err("bad level count", "Invalid argument: at least one mip level must be requested");
+            return false;
+        }
+
+        int w, h;
+        if (!infoFromMemory(data, len, &w, &h, nChannels)) {
+            return false;
+        }
+
+        int n = nDesiredChannels == 0 ? *nChannels : nDesiredChannels;
+        if (mipChainLayout(w, h, n, maxLevels, levels, nLevels) > dstLen) {
+            stbi__err("bad buffer size", "Invalid argument: destination buffer is too small");
+            return false;
+        }
+
+        if (!loadIntoBuffer(data, len, nDesiredChannels, 8, dst, &w, &h, nChannels)) {
+            return false;
+        }
+
+        PostTimer timer{lastFormat};
+        for (int i = 1; i < *nLevels; ++i) {
+            downsample2x2(dst + levels[i - 1].offset, levels[i - 1].width, levels[i - 1].height, n, srgb, dst + levels[i].offset);
+        }
+
+        return true;
+    }
+}
+
+// Receives nRows consecutive rows of pixels, of which the first is row y of an image of size w x h with nChannels channels
+// per pixel. Returning nonzero stops the delivery of further rows. Mirrored by StbiRowCallback in stbi-sharp.cs.
+using RowCallback = int (*)(void* user, int y, int nRows, const unsigned char* rows, int w, int h, int nChannels);
+
+// Receives the outcome of a LoadAsync call on one of the worker threads. On success, pixels points to an image of size
+// w x h with nChannels channels per pixel that has to be released by Free; otherwise, it is null. Mirrored by
+// StbiLoadCallback in stbi-sharp.cs.
+using LoadCallback = void (*)(void* user, void* pixels, int w, int h, int nChannels, Error status, const char* failureReason);
+
+// Receives the next size bytes of an encoded image. Returning nonzero stops the delivery of further bytes, which fails the
+// write. Mirrored by StbiWriteCallback in stbi-sharp.cs.
+using WriteCallback = int (*)(void* user, const void* data, int size);
+
+// Mirrored by StbiDecoderState in stbi-sharp.cs.
+enum DecoderState : int {
+    DecoderNeedsData = 0,
+    // The image's dimensions and number of channels are known, but its pixels are not decoded yet.
+    DecoderHeaderAvailable = 1,
+    DecoderComplete = 2,
+    DecoderFailed = 3,
+};
+
+// Decodes an image whose encoded data arrives piece by piece. stb_image cannot suspend decoding when it runs out of input,
+// so the data is accumulated, and decoded in one go once its end was seen: the IEND chunk of PNGs, the EOI marker of
+// JPEGs, or a call to finish for all other formats. Until then, the header is parsed as soon as it has arrived, such that
+// callers can size their output early. Fed data is copied, such that callers can release their buffers right away, and
+// the copy is released as soon as the image is decoded.
+class Decoder {
+public:
+    Decoder(int nDesiredChannels) : mNDesiredChannels{nDesiredChannels} {}
+
+    ~Decoder() {
+        stbiFree(mData);
+        stbi_image_free(mPixels);
+    }
+
+    Decoder(const Decoder&) = delete;
+    Decoder& operator=(const Decoder&) = delete;
+
+    DecoderState feed(const unsigned char* data, int64_t len) {
+        if (mState == DecoderFailed || mState == DecoderComplete) {
+            return restoreFailure();
+        }
+
+        if (len < 0) {
+            return fail("Invalid argument: negative length");
+        }
+
+        if (mLen + len > mCapacity) {
+            int64_t capacity = mCapacity < 4096 ? 4096 : mCapacity;
+            while (capacity < mLen + len) {
+                capacity *= 2;
+            }
+
+            unsigned char* newData = (unsigned char*)stbiRealloc(mData, (size_t)capacity);
+            if (!newData) {
+                return fail("Out of memory");
+            }
+
+            mData = newData;
+            mCapacity = capacity;
+        }
+
+        if (len > 0) {
+            memcpy(mData + mLen, data, (size_t)len);
+            mLen += len;
+        }
+
+        if (mFormat == FormatUndetermined) {
+            detectFormat();
+        }
+
+        if (mState == DecoderNeedsData && (mFormat == FormatPng || mFormat == FormatJpeg) && infoFromMemory(mData, mLen, &mWidth, &mHeight, &mNChannels)) {
+            mState = DecoderHeaderAvailable;
+        }
+
+        if ((mFormat == FormatPng && scanPng()) || (mFormat == FormatJpeg && scanJpeg())) {
+            return decode();
+        }
+
+        return mState;
+    }
+
+    DecoderState finish() {
+        if (mState == DecoderFailed || mState == DecoderComplete) {
+            return restoreFailure();
+        }
+
+        return decode();
+    }
+
+    DecoderState state() const {
+        return mState;
+    }
+
+    bool info(int* w, int* h, int* nChannels) const {
+        if (mState != DecoderHeaderAvailable && mState != DecoderComplete) {
+            return false;
+        }
+
+        *w = mWidth;
+        *h = mHeight;
+        *nChannels = mNChannels;
+        return true;
+    }
+
+    const unsigned char* rows(int* nRows) const {
+        *nRows = mState == DecoderComplete ? mHeight : 0;
+        return mPixels;
+    }
+
+private:
+    enum Format {
+        FormatUndetermined,
+        FormatPng,
+        FormatJpeg,
+        FormatOther,
+    };
+
+    DecoderState fail(const char* reason) {
+        stbi__err(reason, reason);
+        mFailureReason = reason;
+        mState = DecoderFailed;
+        return mState;
+    }
+
+    // Makes the failure that ended decoding the calling thread's failure again.
+    DecoderState restoreFailure() {
+        if (mState == DecoderFailed) {
+            stbi__err(mFailureReason, mFailureReason);
+        }
+
+        return mState;
+    }
+
+    DecoderState decode() {
+        mPixels = (unsigned char*)loadFromMemory(mData, mLen, &mWidth, &mHeight, &mNChannels, mNDesiredChannels, 8);
+
+        stbiFree(mData);
+        mData = nullptr;
+        mLen = mCapacity = 0;
+
+        if (!mPixels) {
+            return fail(stbi_failure_reason());
+        }
+
+        mState = DecoderComplete;
+        return mState;
+    }
+
+    void detectFormat() {
+        if (mLen >= 2 && mData[0] == 0xFF && mData[1] == 0xD8) {
+            mFormat = FormatJpeg;
+            mScanPos = 2;
+        } else if (mLen >= 8) {
+            mFormat = memcmp(mData, "\x89PNG\r\n\x1A\n", 8) == 0 ? FormatPng : FormatOther;
+            mScanPos = 8;
+        }
+    }
+
+    uint32_t be32(int64_t pos) const {
+        return ((uint32_t)mData[pos] << 24) | ((uint32_t)mData[pos + 1] << 16) | ((uint32_t)mData[pos + 2] << 8) | mData[pos + 3];
+    }
+
+    // Skips from chunk to chunk. Returns true once the IEND chunk has arrived.
+    bool scanPng() {
+        while (mLen - mScanPos >= 8) {
+            if (memcmp(mData + mScanPos + 4, "IEND", 4) == 0) {
+                // Wait for the CRC, too.
+                return mLen - mScanPos >= 12;
+            }
+
+            // Length, type, data, and CRC.
+            mScanPos += 12 + (int64_t)be32(mScanPos);
+        }
+
+        return false;
+    }
+
+    // Skips from marker segment to marker segment and through entropy-coded data, in which 0xFF bytes are followed by a
+    // stuffed 0x00 or a restart marker. Returns true once the EOI marker has arrived.
+    bool scanJpeg() {
+        while (mScanPos < mLen - 1) {
+            if (mInEntropyCodedData) {
+                const unsigned char* ff = (const unsigned char*)memchr(mData + mScanPos, 0xFF, (size_t)(mLen - 1 - mScanPos));
+                if (!ff) {
+                    mScanPos = mLen - 1;
+                    break;
+                }
+
+                mScanPos = ff - mData;
+                unsigned char next = mData[mScanPos + 1];
+                if (next == 0x00 || (next >= 0xD0 && next <= 0xD7)) {
+                    mScanPos += 2;
+                } else if (next == 0xFF) {
+                    mScanPos += 1;
+                } else {
+                    mInEntropyCodedData = false;
+                }
+
+                continue;
+            }
+
+            if (mData[mScanPos] != 0xFF || mData[mScanPos + 1] == 0xFF) {
+                // Fill bytes.
+                mScanPos += 1;
+                continue;
+            }
+
+            unsigned char marker = mData[mScanPos + 1];
+            if (marker == 0xD9) {
+                return true;
+            } else if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+                mScanPos += 2;
+                continue;
+            }
+
+            if (mLen - mScanPos < 4) {
+                break;
+            }
+
+            mScanPos += 2 + (((int64_t)mData[mScanPos + 2] << 8) | mData[mScanPos + 3]);
+            // Progressive JPEGs have multiple scans, each of which starts with an SOS marker.
+            mInEntropyCodedData = marker == 0xDA;
+        }
+
+        return false;
+    }
+
+    int mNDesiredChannels;
+    DecoderState mState = DecoderNeedsData;
+    const char* mFailureReason = nullptr;
+
+    unsigned char* mData = nullptr;
+    int64_t mLen = 0;
+    int64_t mCapacity = 0;
+
+    Format mFormat = FormatUndetermined;
+    int64_t mScanPos = 0;
+    bool mInEntropyCodedData = false;
+
+    int mWidth = 0;
+    int mHeight = 0;
+    int mNChannels = 0;
+    unsigned char* mPixels = nullptr;
+};
+
+#ifndef STBI_NO_GIF
+// Decodes the frames of an animated GIF one at a time. stb_image's stbi_load_gif_from_memory allocates all frames at once,
+// whereas this only keeps the two most recent ones, which are needed to composite the next frame.
+class GifDecoder {
+public:
+    GifDecoder(const unsigned char* data, int64_t len, int nDesiredChannels) : mReader{data, len}, mNDesiredChannels{nDesiredChannels} {
+        if (len > INT_MAX) {
+            stbi__start_callbacks(&mContext, (stbi_io_callbacks*)&MemoryReader::callbacks, &mReader);
+        } else {
+            stbi__start_mem(&mContext, data, (int)len);
+        }
+
+        memset(&mGif, 0, sizeof(mGif));
+    }
+
+    ~GifDecoder() {
+        STBI_FREE(mGif.out);
+        STBI_FREE(mGif.history);
+        STBI_FREE(mGif.background);
+        stbiFree(mTwoBack);
+        stbiFree(mPrevious);
+    }
+
+    GifDecoder(const GifDecoder&) = delete;
+    GifDecoder& operator=(const GifDecoder&) = delete;
+
+    // Rewinds the data afterwards.
+    bool isGif() {
+        return stbi__gif_test(&mContext) != 0;
+    }
+
+    // Returns 1 if a frame was written to dst, 0 at the end of the animation, and -1 on failure.
+    int next(unsigned char* dst, int* delayMs) {
+        if (mDone) {
+            return 0;
+        }
+
+        int nChannels;
+        unsigned char* frame = stbi__gif_load_next(&mContext, &mGif, &nChannels, mNDesiredChannels, mNFrames >= 2 ? mTwoBack : nullptr);
+        if (frame == (unsigned char*)&mContext) {
+            mDone = true;
+            return 0;
+        } else if (!frame) {
+            mDone = true;
+            return -1;
+        }
+
+        size_t size = (size_t)mGif.w * mGif.h * 4;
+        if (!mPrevious) {
+            mPrevious = (unsigned char*)stbiMalloc(size);
+            mTwoBack = (unsigned char*)stbiMalloc(size);
+            if (!mPrevious || !mTwoBack) {
+                stbi__err("outofmem", "Out of memory");
+                return -1;
+            }
+        }
+
+        // The frame that was previous so far becomes the one two frames back.
+        unsigned char* twoBack = mTwoBack;
+        mTwoBack = mPrevious;
+        mPrevious = twoBack;
+        memcpy(mPrevious, frame, size);
+        ++mNFrames;
+
+        convertFromRgba(frame, (size_t)mGif.w * mGif.h, dst);
+        *delayMs = mGif.delay;
+        return 1;
+    }
+
+private:
+    // Frames are always RGBA. Grey is computed with the same weights as stb_image's channel conversion.
+    void convertFromRgba(const unsigned char* src, size_t nPixels, unsigned char* dst) const {
+        int n = mNDesiredChannels == 0 ? 4 : mNDesiredChannels;
+        if (n == 4) {
+            memcpy(dst, src, nPixels * 4);
+            return;
+        }
+
+        for (size_t i = 0; i < nPixels; ++i) {
+            const unsigned char* p = src + i * 4;
+            unsigned char* q = dst + i * n;
+            switch (n) {
+                case 1: q[0] = (unsigned char)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8); break;
+                case 2: q[0] = (unsigned char)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8); q[1] = p[3]; break;
+                case 3: q[0] = p[0]; q[1] = p[1]; q[2] = p[2]; break;
+            }
+        }
+    }
+
+    MemoryReader mReader;
+    int mNDesiredChannels;
+    stbi__context mContext;
+    stbi__gif mGif;
+
+    bool mDone = false;
+    int mNFrames = 0;
+    unsigned char* mPrevious = nullptr;
+    unsigned char* mTwoBack = nullptr;
+};
 #else
-    #define EXPORT
+class GifDecoder;
 #endif
 
+namespace {
+    // The last reference to a pool may be dropped by a task on one of its own threads, or while asyncPoolMutex is held, so
+    // pools are destroyed on a thread of their own, which waits for their queued tasks and joins their threads.
+    std::shared_ptr<WorkerPool> makeAsyncPool(int nThreads, size_t queueCapacity) {
+        return std::shared_ptr<WorkerPool>{new WorkerPool{nThreads, queueCapacity}, [](WorkerPool* pool) {
+            try {
+                std::thread{[pool] { delete pool; }}.detach();
+            } catch (const std::system_error&) {
+                // Without a thread to spare, the pool's threads are left waiting for tasks rather than risking a deadlock.
+            }
+        }};
+    }
+
+    std::mutex asyncPoolMutex;
+    // Intentionally leaked, such that the worker threads are not joined while the library is being unloaded. Tasks hold
+    // on to the pool that they were submitted to, such that reconfiguring it does not cut them short.
+    std::shared_ptr<WorkerPool>* asyncPool = nullptr;
+
+    // Creates the pool with one thread per hardware thread and a queue of 4 tasks per thread if it was not configured.
+    std::shared_ptr<WorkerPool> getAsyncPool() {
+        std::lock_guard<std::mutex> lock{asyncPoolMutex};
+        if (!asyncPool) {
+            int nThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+            asyncPool = new std::shared_ptr<WorkerPool>{makeAsyncPool(nThreads, (size_t)nThreads * 4)};
+        }
+
+        return *asyncPool;
+    }
+
+    bool isCancelled(const volatile int* cancelled) {
+        if (cancelled && *cancelled) {
+            stbi__err("cancelled", "Load was cancelled");
+            return true;
+        }
+
+        return false;
+    }
+
+    // Forwards the output of stb_image_write to a WriteCallback. stb_image_write cannot be stopped midway, so once the
+    // callback asks to stop, the remaining output is dropped.
+    class Writer {
+    public:
+        Writer(WriteCallback callback, void* user) : mCallback{callback}, mUser{user} {}
+
+        static void write(void* context, void* data, int size) {
+            Writer* self = (Writer*)context;
+            if (!self->mStopped && size > 0) {
+                self->mStopped = self->mCallback(self->mUser, data, size) != 0;
+            }
+        }
+
+        bool finish(int result) const {
+            if (mStopped) {
+                stbi__err("cancelled", "Write was cancelled by the callback");
+                return false;
+            }
+
+            // Arguments are checked up front, so stb_image_write only fails when it runs out of memory.
+            if (!result) {
+                stbi__err("outofmem", "Out of memory");
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        WriteCallback mCallback;
+        void* mUser;
+        bool mStopped = false;
+    };
+
+    bool checkWrite(const void* pixels, int w, int h, int nChannels, WriteCallback callback) {
+        if (!pixels || !callback) {
+            stbi__err("bad argument", "Invalid argument: neither pixels nor callback may be null");
+            return false;
+        }
+
+        if (w <= 0 || h <= 0) {
+            stbi__err("bad size", "Invalid argument: width and height must be positive");
+            return false;
+        }
+
+        if (nChannels < 1 || nChannels > 4) {
+            stbi__err("bad channel count", "Invalid argument: number of channels must be between 1 and 4");
+            return false;
+        }
+
+        // stb_image_write sizes its buffers with ints, including a filter byte per row of PNGs.
+        if (((int64_t)w * nChannels + 1) * h > INT_MAX) {
+            stbi__err("too large", "Image is too large to be encoded");
+            return false;
+        }
+
+        return true;
+    }
+}
+
 extern "C" {
     EXPORT bool LoadFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, unsigned char* dst) {
-        // Dummy variables that are not going to be used. Returning them is unnecessary, because the probided destination buffer
+        // Dummy variables that are not going to be used. Returning them is unnecessary, because the provided destination buffer
         // needs to already have the correct size, hence the caller must have already requested the width, height, and number of
         // channels beforehand.
         int width, height, nChannels;
-        unsigned char* tmp = stbi_load_from_memory(data, (int)len, &width, &height, &nChannels, nDesiredChannels);
+        return track(loadIntoBuffer(data, len, nDesiredChannels, 8, dst, &width, &height, &nChannels));
+    }
 
-        if (!tmp) {
-            return false;
+    EXPORT bool LoadFromMemoryIntoBufferWithOptions(const unsigned char* data, int64_t len, const LoadOptions* options, void* dst, int64_t dstLen) {
+        if (!checkConversion(options)) {
+            return track(false);
         }
 
-        size_t nBytes = ((size_t)width * height) * nDesiredChannels;
-        for (size_t i = 0; i < nBytes; ++i) {
-            dst[i] = tmp[i];
+        ScopedFlip flip{options->flipVertically != 0};
+        ScopedThreads threads{options->nThreads};
+        int width, height, nChannels;
+        if (!loadIntoBuffer(data, len, options->nDesiredChannels, options->bitsPerChannel == 0 ? 8 : options->bitsPerChannel, dst, &width, &height, &nChannels, exportedLen(dstLen))) {
+            return track(false);
         }
 
-        stbi_image_free(tmp);
-        return true;
+        convert(dst, width, height, options->nDesiredChannels == 0 ? nChannels : options->nDesiredChannels, options);
+        return track(true);
+    }
+
+    EXPORT bool LoadFromMemoryIntoStridedBuffer(const unsigned char* data, int64_t len, const LoadOptions* options, void* dst, int64_t dstLen, int64_t rowStride) {
+        if (!checkConversion(options)) {
+            return track(false);
+        }
+
+        return track(loadIntoStridedBuffer(data, len, options, (unsigned char*)dst, dstLen, rowStride));
+    }
+
+    EXPORT bool LoadPlanarFromMemoryIntoBuffer(const unsigned char* data, int64_t len, const LoadOptions* options, const PlanarOptions* planar, void* dst, int64_t dstLen, int* w, int* h, int* nChannels) {
+        if (!checkConversion(options)) {
+            return track(false);
+        }
+
+        return track(loadPlanarIntoBuffer(data, len, options, planar, dst, dstLen, w, h, nChannels));
+    }
+
+    EXPORT int64_t MipChainLayout(int w, int h, int nChannels, int maxLevels, MipLevel* levels, int* nLevels) {
+        return mipChainLayout(w, h, nChannels, maxLevels, levels, nLevels);
+    }
+
+    // levels must have room for maxLevels entries.
+    EXPORT bool LoadMipChainFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, int srgb, int maxLevels, unsigned char* dst, int64_t dstLen, MipLevel* levels, int* nLevels) {
+        int nChannels;
+        return track(loadMipChainIntoBuffer(data, len, nDesiredChannels, srgb != 0, maxLevels, dst, dstLen, levels, nLevels, &nChannels));
+    }
+
+    EXPORT unsigned char* LoadMipChainFromMemory(const unsigned char* data, int64_t len, int nDesiredChannels, int srgb, int maxLevels, MipLevel* levels, int* nLevels, int* nChannels) {
+        if (maxLevels < 1) {
+            stbi__err("bad level count", "Invalid argument: at least one mip level must be requested");
+            return track<unsigned char*>(nullptr);
+        }
+
+        int w, h;
+        if (!infoFromMemory(data, len, &w, &h, nChannels)) {
+            return track<unsigned char*>(nullptr);
+        }
+
+        int64_t size = mipChainLayout(w, h, nDesiredChannels == 0 ? *nChannels : nDesiredChannels, maxLevels, levels, nLevels);
+        unsigned char* chain = (unsigned char*)stbiMalloc((size_t)size);
+        if (!chain) {
+            stbi__err("outofmem", "Out of memory");
+            return track<unsigned char*>(nullptr);
+        }
+
+        if (!loadMipChainIntoBuffer(data, len, nDesiredChannels, srgb != 0, maxLevels, chain, size, levels, nLevels, nChannels)) {
+            stbiFree(chain);
+            return track<unsigned char*>(nullptr);
+        }
+
+        return track(chain);
+    }
+
+    EXPORT bool Load16FromMemoryIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, unsigned short* dst, int64_t dstLen) {
+        int width, height, nChannels;
+        return track(loadIntoBuffer(data, len, nDesiredChannels, 16, dst, &width, &height, &nChannels, exportedLen(dstLen)));
+    }
+
+    EXPORT bool LoadFFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int nDesiredChannels, float* dst, int64_t dstLen) {
+        int width, height, nChannels;
+        return track(loadIntoBuffer(data, len, nDesiredChannels, 32, dst, &width, &height, &nChannels, exportedLen(dstLen)));
+    }
+
+    EXPORT bool LoadRegionFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int x, int y, int w, int h, int nDesiredChannels, unsigned char* dst, int64_t dstLen) {
+        int nChannels;
+        return track(loadRegionIntoBuffer(data, len, x, y, w, h, nDesiredChannels, dst, &nChannels, exportedLen(dstLen)));
+    }
+
+    EXPORT unsigned char* LoadRegionFromMemory(const unsigned char* data, int64_t len, int x, int y, int w, int h, int* nChannels, int nDesiredChannels) {
+        return track(loadRegion(data, len, x, y, w, h, nChannels, nDesiredChannels));
+    }
+
+    EXPORT bool LoadScaledFromMemoryIntoBuffer(const unsigned char* data, int64_t len, int scaleDenominator, int nDesiredChannels, unsigned char* dst, int64_t dstLen) {
+        int width, height, nChannels;
+        return track(loadScaledIntoBuffer(data, len, scaleDenominator, nDesiredChannels, dst, &width, &height, &nChannels, exportedLen(dstLen)));
+    }
+
+    EXPORT unsigned char* LoadScaledFromMemory(const unsigned char* data, int64_t len, int scaleDenominator, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        return track(loadScaled(data, len, scaleDenominator, w, h, nChannels, nDesiredChannels));
+    }
+
+    EXPORT bool ReloadFromMemory(const unsigned char* data, int64_t len, int nDesiredChannels, unsigned char** pixels, int64_t* capacity, int* w, int* h, int* nChannels) {
+        int width, height, nSourceChannels;
+        if (!infoFromMemory(data, len, &width, &height, &nSourceChannels)) {
+            return track(false);
+        }
+
+        int64_t size = ((int64_t)width * height) * (nDesiredChannels == 0 ? nSourceChannels : nDesiredChannels);
+        if (!*pixels || size > *capacity) {
+            stbiFree(*pixels);
+            *capacity = 0;
+
+            *pixels = (unsigned char*)stbiMalloc((size_t)size);
+            if (!*pixels) {
+                stbi__err("outofmem", "Out of memory");
+                return track(false);
+            }
+
+            *capacity = size;
+        }
+
+        if (!loadIntoBuffer(data, len, nDesiredChannels, 8, *pixels, &width, &height, &nSourceChannels)) {
+            return track(false);
+        }
+
+        *w = width;
+        *h = height;
+        *nChannels = nSourceChannels;
+        return track(true);
     }
 
     EXPORT bool InfoFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels) {
-        return stbi_info_from_memory(data, (int)len, w, h, nChannels) == 1;
+        return track(infoFromMemory(data, len, w, h, nChannels));
     }
 
     EXPORT unsigned char* LoadFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels) {
-        return stbi_load_from_memory(data, (int)len, w, h, nChannels, nDesiredChannels);
+        return track((unsigned char*)loadFromMemory(data, len, w, h, nChannels, nDesiredChannels, 8));
+    }
+
+    EXPORT unsigned short* Load16FromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        return track((unsigned short*)loadFromMemory(data, len, w, h, nChannels, nDesiredChannels, 16));
+    }
+
+    EXPORT float* LoadFFromMemory(const unsigned char* data, int64_t len, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        return track((float*)loadFromMemory(data, len, w, h, nChannels, nDesiredChannels, 32));
+    }
+
+    EXPORT bool IsHdrFromMemory(const unsigned char* data, int64_t len) {
+        return isHdrFromMemory(data, len);
+    }
+
+    EXPORT bool Is16BitFromMemory(const unsigned char* data, int64_t len) {
+        return is16BitFromMemory(data, len);
+    }
+
+    EXPORT void* LoadFromMemoryWithOptions(const unsigned char* data, int64_t len, const LoadOptions* options, int* w, int* h, int* nChannels) {
+        if (!checkConversion(options)) {
+            return track<void*>(nullptr);
+        }
+
+        ScopedFlip flip{options->flipVertically != 0};
+        ScopedThreads threads{options->nThreads};
+        void* pixels = loadFromMemory(data, len, w, h, nChannels, options->nDesiredChannels, options->bitsPerChannel == 0 ? 8 : options->bitsPerChannel);
+        if (pixels) {
+            convert(pixels, *w, *h, options->nDesiredChannels == 0 ? *nChannels : options->nDesiredChannels, options);
+        }
+
+        return track(pixels);
+    }
+
+    // Replaces the pool on which LoadAsync decodes and returns without waiting for the previous pool. Loads that are already
+    // queued still complete on it, and its threads exit once it has drained. May be called from a LoadAsync callback.
+    // Supplying nThreads <= 0 uses one thread per hardware thread.
+    EXPORT void ConfigureAsyncPool(int nThreads, int queueCapacity) {
+        if (nThreads <= 0) {
+            nThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+        }
+
+        auto pool = makeAsyncPool(nThreads, queueCapacity <= 0 ? (size_t)nThreads * 4 : (size_t)queueCapacity);
+        std::lock_guard<std::mutex> lock{asyncPoolMutex};
+        if (asyncPool) {
+            // The previous pool is released once the lock is, by the destructor of pool.
+            std::swap(*asyncPool, pool);
+        } else {
+            asyncPool = new std::shared_ptr<WorkerPool>{std::move(pool)};
+        }
+    }
+
+    // The number of loads that can be running or queued before LoadAsync blocks.
+    EXPORT int64_t AsyncPoolCapacity() {
+        return (int64_t)getAsyncPool()->capacity();
+    }
+
+    // The number of loads that can be queued before LoadAsync blocks. A worker only dequeues the next load once the callback
+    // of its current one has returned, so callers that count loads until their callbacks are invoked must stay within
+    // this rather than AsyncPoolCapacity to never block.
+    EXPORT int64_t AsyncPoolQueueCapacity() {
+        return (int64_t)getAsyncPool()->queueCapacity();
+    }
+
+    // Queues a load and returns right away, unless the queue is full, in which case it blocks until a worker frees a slot.
+    // data, options, and cancelled have to stay valid until the callback was invoked. Setting *cancelled to nonzero stops
+    // the load at the next point at which it is checked: before it starts, whenever stb_image refills its input buffer,
+    // and before post-processing; the callback then reports ErrorCancelled. Loads with a flag read through a MemoryReader and
+    // are therefore decoded serially, regardless of options->nThreads, so cancelled should be null for loads that cannot
+    // be cancelled.
+    EXPORT bool LoadAsync(const unsigned char* data, int64_t len, const LoadOptions* options, const volatile int* cancelled, LoadCallback callback, void* user) {
+        if (!callback || !options) {
+            stbi__err("bad callback", "Invalid argument: neither callback nor options may be null");
+            return track(false);
+        }
+
+        auto pool = getAsyncPool();
+        pool->submit([pool, data, len, options, cancelled, callback, user] {
+            int w = 0, h = 0, nChannels = 0;
+            void* pixels = nullptr;
+            if (!isCancelled(cancelled) && checkConversion(options)) {
+                ScopedFlip flip{options->flipVertically != 0};
+                ScopedThreads threads{options->nThreads};
+                pixels = loadFromMemory(data, len, &w, &h, &nChannels, options->nDesiredChannels, options->bitsPerChannel == 0 ? 8 : options->bitsPerChannel, cancelled);
+                // A cancelled load may also fail outright, because the input appears truncated to stb_image.
+                if (isCancelled(cancelled)) {
+                    stbiFree(pixels);
+                    pixels = nullptr;
+                }
+
+                if (pixels) {
+                    convert(pixels, w, h, options->nDesiredChannels == 0 ? nChannels : options->nDesiredChannels, options);
+                }
+            }
+
+            track(pixels);
+            callback(user, pixels, w, h, nChannels, lastError, lastFailureReason);
+        });
+
+        return track(true);
+    }
+
+    EXPORT unsigned char* LoadFromCallbacks(const stbi_io_callbacks* callbacks, void* user, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        return track(stbi_load_from_callbacks(callbacks, user, w, h, nChannels, nDesiredChannels));
+    }
+
+    EXPORT unsigned char* LoadFromFile(const char* path, int* w, int* h, int* nChannels, int nDesiredChannels) {
+        MappedFile file{path};
+        if (!file.data()) {
+            return track<unsigned char*>(nullptr);
+        }
+
+        return track((unsigned char*)loadFromMemory(file.data(), file.size(), w, h, nChannels, nDesiredChannels, 8));
+    }
+
+    EXPORT bool InfoFromFile(const char* path, int* w, int* h, int* nChannels) {
+        MappedFile file{path};
+        if (!file.data()) {
+            return track(false);
+        }
+
+        return track(infoFromMemory(file.data(), file.size(), w, h, nChannels));
+    }
+
+    EXPORT void LoadBatch(BatchItem* items, int64_t nItems, int nThreads) {
+        parallelFor((size_t)nItems, nThreads, [items](size_t i) {
+            BatchItem& item = items[i];
+            bool success;
+            if (item.dst) {
+                success = loadIntoBuffer(item.data, item.len, item.nDesiredChannels, 8, item.dst, &item.width, &item.height, &item.nChannels, item.dstLen);
+            } else {
+                item.dst = (unsigned char*)loadFromMemory(item.data, item.len, &item.width, &item.height, &item.nChannels, item.nDesiredChannels, 8);
+                success = item.dst != nullptr;
+            }
+
+            track(success);
+            item.status = lastError;
+            item.failureReason = lastFailureReason;
+        });
+    }
+
+    // Non-interlaced PNGs are decoded band by band through PngRows, such that only a band of nRowsPerCall rows is held at
+    // any time. Other images, and PNGs that are flipped on load, are decoded entirely by stb_image before the rows are
+    // delivered band by band; the image is freed as soon as the last band was delivered, before this function returns.
+    EXPORT bool LoadRowsFromMemory(const unsigned char* data, int64_t len, int nDesiredChannels, int nRowsPerCall, RowCallback callback, void* user) {
+        if (nRowsPerCall < 1) {
+            stbi__err("bad rows per call", "Invalid argument: rows per call must be positive");
+            return track(false);
+        }
+
+        if (!data || len < 0) {
+            stbi__err("bad argument", "Invalid argument: data may neither be null nor have a negative length");
+            return track(false);
+        }
+
+        PngRows png;
+        if (!stbi__vertically_flip_on_load && png.parse(data, len, nDesiredChannels)) {
+            int nRows = std::min(nRowsPerCall, png.height());
+            size_t stride = (size_t)png.width() * png.nOutChannels();
+            unsigned char* band = (unsigned char*)stbiMalloc(stride * nRows);
+            if (!band) {
+                stbi__err("outofmem", "Out of memory");
+                return track(false);
+            }
+
+            bool success = true;
+            for (int y = 0; y < png.height() && success; y += nRows) {
+                int nBandRows = std::min(png.height() - y, nRows);
+                for (int i = 0; i < nBandRows && success; ++i) {
+                    success = png.nextRow(band + i * stride);
+                }
+
+                if (success && callback(user, y, nBandRows, band, png.width(), png.height(), png.nOutChannels()) != 0) {
+                    break;
+                }
+            }
+
+            stbiFree(band);
+            return track(success);
+        }
+
+        int width, height, nChannels;
+        unsigned char* pixels = (unsigned char*)loadFromMemory(data, len, &width, &height, &nChannels, nDesiredChannels, 8);
+        if (!pixels) {
+            return track(false);
+        }
+
+        size_t stride = (size_t)width * (nDesiredChannels == 0 ? nChannels : nDesiredChannels);
+        for (int y = 0; y < height; y += nRowsPerCall) {
+            int nRows = height - y < nRowsPerCall ? height - y : nRowsPerCall;
+            if (callback(user, y, nRows, pixels + y * stride, width, height, nDesiredChannels == 0 ? nChannels : nDesiredChannels) != 0) {
+                break;
+            }
+        }
+
+        stbi_image_free(pixels);
+        return track(true);
+    }
+
+    // data must remain valid until the decoder is closed.
+    EXPORT GifDecoder* OpenGif(const unsigned char* data, int64_t len, int nDesiredChannels, int* w, int* h, int* nChannels) {
+#ifdef STBI_NO_GIF
+        stbi__err("not GIF", "Unsupported: GIF support was disabled at compile time");
+        return track<GifDecoder*>(nullptr);
+#else
+        if (nDesiredChannels < 0 || nDesiredChannels > 4) {
+            stbi__err("bad req_comp", "Invalid argument: bad number of desired channels");
+            return track<GifDecoder*>(nullptr);
+        }
+
+        if (!infoFromMemory(data, len, w, h, nChannels)) {
+            return track<GifDecoder*>(nullptr);
+        }
+
+        GifDecoder* decoder = (GifDecoder*)stbiMalloc(sizeof(GifDecoder));
+        if (!decoder) {
+            stbi__err("outofmem", "Out of memory");
+            return track<GifDecoder*>(nullptr);
+        }
+
+        new (decoder) GifDecoder{data, len, nDesiredChannels};
+        if (!decoder->isGif()) {
+            decoder->~GifDecoder();
+            stbiFree(decoder);
+            stbi__err("not GIF", "Image is not a GIF");
+            return track<GifDecoder*>(nullptr);
+        }
+
+        *nChannels = nDesiredChannels == 0 ? 4 : nDesiredChannels;
+        return track(decoder);
+#endif
+    }
+
+    EXPORT int NextGifFrame(GifDecoder* decoder, unsigned char* dst, int* delayMs) {
+#ifdef STBI_NO_GIF
+        return -1;
+#else
+        int result = decoder->next(dst, delayMs);
+        track(result >= 0);
+        return result;
+#endif
+    }
+
+    EXPORT void CloseGif(GifDecoder* decoder) {
+#ifndef STBI_NO_GIF
+        if (decoder) {
+            decoder->~GifDecoder();
+            stbiFree(decoder);
+        }
+#endif
+    }
+
+    EXPORT Decoder* CreateDecoder(int nDesiredChannels) {
+        Decoder* decoder = (Decoder*)stbiMalloc(sizeof(Decoder));
+        if (!decoder) {
+            stbi__err("outofmem", "Out of memory");
+            return track<Decoder*>(nullptr);
+        }
+
+        return track(new (decoder) Decoder{nDesiredChannels});
+    }
+
+    EXPORT int FeedDecoder(Decoder* decoder, const unsigned char* data, int64_t len) {
+        DecoderState state = decoder->feed(data, len);
+        track(state != DecoderFailed);
+        return state;
+    }
+
+    EXPORT int FinishDecoder(Decoder* decoder) {
+        DecoderState state = decoder->finish();
+        track(state != DecoderFailed);
+        return state;
+    }
+
+    EXPORT bool DecoderInfo(Decoder* decoder, int* w, int* h, int* nChannels) {
+        return decoder->info(w, h, nChannels);
+    }
+
+    EXPORT const unsigned char* DecoderRows(Decoder* decoder, int* nRows) {
+        return decoder->rows(nRows);
+    }
+
+    EXPORT void DestroyDecoder(Decoder* decoder) {
+        if (decoder) {
+            decoder->~Decoder();
+            stbiFree(decoder);
+        }
+    }
+
+    EXPORT void InfoBatch(InfoItem* items, int64_t nItems, int nThreads) {
+        parallelFor((size_t)nItems, nThreads, [items](size_t i) {
+            InfoItem& item = items[i];
+            bool isHdr = false;
+            bool success = probeFromMemory(item.data, item.len, &item.width, &item.height, &item.nChannels, &isHdr, &item.bitsPerChannel);
+            item.isHdr = isHdr;
+
+            track(success);
+            item.status = lastError;
+            item.failureReason = lastFailureReason;
+        });
     }
 
     EXPORT void SetFlipVerticallyOnLoad(int shouldFlip) {
@@ -54,7 +2565,145 @@ extern "C" {
         stbi_image_free(pixels);
     }
 
+    EXPORT void SetAllocator(HostMalloc hostMalloc, HostFree hostFree, void* user) {
+        setHostAllocator(hostMalloc, hostFree, user);
+    }
+
+    EXPORT void SetArenaCapacity(int64_t nBytes) {
+        setArenaCapacity(nBytes);
+    }
+
+    EXPORT void GetAllocatorStats(AllocatorStats* stats) {
+        getAllocatorStats(stats);
+    }
+
+    EXPORT void SetStatsEnabled(int enabled) {
+        setStatsEnabled(enabled != 0);
+    }
+
+    // Copies the statistics of at most nFormats formats into formats, indexed by ImageFormat, as well as the peak number of
+    // bytes that were allocated at once since statistics were last reset.
+    EXPORT void GetStats(FormatStats* formats, int nFormats, int64_t* nPeakLiveBytes) {
+        getStats(formats, nFormats);
+
+        AllocatorStats allocatorStats;
+        getAllocatorStats(&allocatorStats);
+        *nPeakLiveBytes = allocatorStats.nPeakLiveBytes;
+    }
+
+    EXPORT void ResetStats() {
+        resetStats();
+        resetPeakLiveBytes();
+    }
+
+    // Encodes 8-bit pixels as PNG and passes the result to callback piece by piece. Rows are rowStride bytes apart; 0 means
+    // that they are packed. The zlib compression level ranges from 1 (fastest) to 9 (smallest), where 0 means 8, and only
+    // applies to this call.
+    EXPORT bool WritePngToMemory(const unsigned char* pixels, int w, int h, int nChannels, int64_t rowStride, int compressionLevel, WriteCallback callback, void* user) {
+        if (!checkWrite(pixels, w, h, nChannels, callback)) {
+            return track(false);
+        }
+
+        if (rowStride == 0) {
+            rowStride = (int64_t)w * nChannels;
+        }
+
+        if (rowStride < (int64_t)w * nChannels || rowStride > INT_MAX) {
+            stbi__err("bad stride", "Invalid argument: row stride is smaller than a row of pixels or exceeds INT_MAX");
+            return track(false);
+        }
+
+        pngCompressionLevel = compressionLevel == 0 ? 8 : std::min(std::max(compressionLevel, 1), 9);
+        Writer writer{callback, user};
+        return track(writer.finish(stbi_write_png_to_func(&Writer::write, &writer, w, h, nChannels, pixels, (int)rowStride)));
+    }
+
+    // Encodes packed 8-bit pixels as baseline JPEG of the given quality, from 1 to 100, where 0 means 90. Alpha is ignored.
+    EXPORT bool WriteJpgToMemory(const unsigned char* pixels, int w, int h, int nChannels, int quality, WriteCallback callback, void* user) {
+        if (!checkWrite(pixels, w, h, nChannels, callback)) {
+            return track(false);
+        }
+
+        Writer writer{callback, user};
+        return track(writer.finish(stbi_write_jpg_to_func(&Writer::write, &writer, w, h, nChannels, pixels, quality)));
+    }
+
+    // Encodes packed float pixels in linear light as Radiance HDR. Alpha is ignored.
+    EXPORT bool WriteHdrToMemory(const float* pixels, int w, int h, int nChannels, WriteCallback callback, void* user) {
+        if (!checkWrite(pixels, w, h, nChannels, callback)) {
+            return track(false);
+        }
+
+        Writer writer{callback, user};
+        return track(writer.finish(stbi_write_hdr_to_func(&Writer::write, &writer, w, h, nChannels, pixels)));
+    }
+
+    // Inflates a zlib stream, or a raw deflate stream unless parseHeader is set, into dst and stores the number of
+    // inflated bytes in outLen. Fails if dst is too small.
+    EXPORT bool ZlibDecode(const char* data, int64_t len, char* dst, int64_t dstLen, int parseHeader, int64_t* outLen) {
+        if (!data || !dst || len < 0 || dstLen < 0) {
+            stbi__err("bad argument", "Invalid argument: neither data nor dst may be null or have a negative length");
+            return track(false);
+        }
+
+#ifdef STBI_USE_LIBDEFLATE
+        libdeflate_result result = inflateInto(data, len, dst, dstLen, parseHeader != 0, outLen);
+        if (result == LIBDEFLATE_INSUFFICIENT_SPACE) {
+            stbi__err("bad buffer size", "Invalid argument: destination buffer is too small");
+            return track(false);
+        } else if (result != LIBDEFLATE_SUCCESS) {
+            stbi__err("bad zlib", "Corrupt zlib data");
+            return track(false);
+        }
+
+        return track(true);
+#else
+        if (len > INT_MAX) {
+            stbi__err("too large", "Compressed data is too large for stb_image's inflate");
+            return track(false);
+        }
+
+        // stb_image reports a destination buffer that is too small like corrupt data.
+        int dstSize = (int)std::min(dstLen, (int64_t)INT_MAX);
+        int nBytes = parseHeader ? stbi_zlib_decode_buffer(dst, dstSize, data, (int)len) : stbi_zlib_decode_noheader_buffer(dst, dstSize, data, (int)len);
+        *outLen = nBytes;
+        return track(nBytes >= 0);
+#endif
+    }
+
+    // Like ZlibDecode, but inflates into memory that it allocates and that has to be released by Free. initialSize is the
+    // expected number of inflated bytes, if known, or 0 otherwise.
+    EXPORT char* ZlibDecodeMalloc(const char* data, int64_t len, int64_t initialSize, int parseHeader, int64_t* outLen) {
+        if (!data || len < 0) {
+            stbi__err("bad argument", "Invalid argument: data may neither be null nor have a negative length");
+            return track<char*>(nullptr);
+        }
+
+        // Without a known size, the guess is clamped to what stb_image's inflate can start out with, so that inputs beyond
+        // 512 MiB are not rejected as too large unless they actually are.
+        if (initialSize <= 0) {
+            initialSize = len > INT_MAX / 4 ? INT_MAX : len * 4;
+        }
+
+        return track(inflate(data, len, initialSize, outLen, parseHeader != 0));
+    }
+
+    EXPORT const char* ActiveKernels() {
+        static char kernels[64];
+        static bool initialized = [] {
+            snprintf(kernels, sizeof(kernels), "jpeg: %s, channels: %s", jpegKernel(), activeChannelKernel());
+            return true;
+        }();
+
+        (void)initialized;
+        return kernels;
+    }
+
     EXPORT const char* FailureReason() {
-        return stbi_failure_reason();
+        return lastFailureReason;
+    }
+
+    EXPORT int LastError() {
+        return lastError;
     }
 }
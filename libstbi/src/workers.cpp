@@ -0,0 +1,84 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#include "workers.h"
+
+#include <system_error>
+
+WorkerPool::WorkerPool(int nThreads, size_t queueCapacity) : mQueueCapacity{queueCapacity < 1 ? 1 : queueCapacity} {
+    if (nThreads <= 0) {
+        nThreads = (int)std::thread::hardware_concurrency();
+    }
+
+    if (nThreads <= 0) {
+        nThreads = 1;
+    }
+
+    for (int i = 0; i < nThreads; ++i) {
+        try {
+            mThreads.emplace_back([this] { work(); });
+        } catch (const std::system_error&) {
+            // Queued tasks would never run without any threads.
+            if (mThreads.empty()) {
+                throw;
+            }
+
+            break;
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mStopping = true;
+    }
+
+    mNotEmpty.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        mNotFull.wait(lock, [this] { return mQueue.size() < mQueueCapacity; });
+        mQueue.emplace_back(std::move(task));
+    }
+
+    mNotEmpty.notify_one();
+}
+
+bool WorkerPool::trySubmit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        if (mQueue.size() >= mQueueCapacity) {
+            return false;
+        }
+
+        mQueue.emplace_back(std::move(task));
+    }
+
+    mNotEmpty.notify_one();
+    return true;
+}
+
+void WorkerPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{mMutex};
+            mNotEmpty.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty()) {
+                return;
+            }
+
+            task = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        mNotFull.notify_one();
+        task();
+    }
+}
@@ -0,0 +1,54 @@
+// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that run tasks from a bounded queue. The threads persist across calls, so submitting a task does
+// not spawn a thread, and the caller does not wait for the task to complete.
+class WorkerPool {
+public:
+    // Supplying nThreads <= 0 uses one thread per hardware thread. If not all threads can be created, the pool makes do with
+    // those that could; it throws std::system_error only if not even one could be.
+    WorkerPool(int nThreads, size_t queueCapacity);
+
+    // Runs all tasks that are still queued, then joins the threads.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Blocks while the queue is full.
+    void submit(std::function<void()> task);
+
+    // Like submit, but returns false rather than blocking while the queue is full.
+    bool trySubmit(std::function<void()> task);
+
+    // The number of tasks that can be running or queued without submit blocking.
+    size_t capacity() const {
+        return mThreads.size() + mQueueCapacity;
+    }
+
+    // The number of tasks that can be queued without submit blocking, regardless of how many are running.
+    size_t queueCapacity() const {
+        return mQueueCapacity;
+    }
+
+private:
+    void work();
+
+    size_t mQueueCapacity;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mNotEmpty;
+    std::condition_variable mNotFull;
+    std::deque<std::function<void()>> mQueue;
+    bool mStopping = false;
+};
@@ -1,280 +1,4191 @@
-﻿// This file was developed by Thomas Müller <thomas94@gmx.net>.
-// It is published under the BSD 3-Clause License within the LICENSE file.
-
-using System;
-using System.IO;
-using System.Runtime.InteropServices;
-
-namespace StbiSharp
-{
-    /// <summary>
-    /// A disposable class that exposes image data and metadata for images loaded via STBI.
-    /// On disposal, frees any native memory that has been allocated to store the image data.
-    /// </summary>
-    unsafe public class StbiImage : IDisposable
-    {
-        private byte* data = null;
-
-        /// <summary>
-        /// The width of the image in number of pixels.
-        /// </summary>
-        public int Width { get; private set; }
-
-        /// <summary>
-        /// The height of the image in number of pixels.
-        /// </summary>
-        public int Height { get; private set; }
-
-        /// <summary>
-        /// The number of colour channels of the image.
-        /// </summary>
-        public int NumChannels { get; private set; }
-
-        /// <summary>
-        /// The raw image data. It is stored in in row-major order, pixel by pixel. Each pixel consists
-        /// of <see cref="NumChannels"/> bytes ordered RGBA.
-        /// </summary>
-        public ReadOnlySpan<byte> Data => new ReadOnlySpan<byte>(data, Width * Height * NumChannels);
-
-        internal StbiImage(byte* data, int width, int height, int numChannels)
-        {
-            this.data = data;
-
-            Width = width;
-            Height = height;
-            NumChannels = numChannels;
-        }
-
-        #region IDisposable Support
-
-        protected virtual void Dispose(bool disposing)
-        {
-            if (data != null)
-            {
-                Stbi.Free(data);
-                data = null;
-            }
-        }
-
-        ~StbiImage()
-        {
-            Dispose(false);
-        }
-
-        public void Dispose()
-        {
-            Dispose(true);
-            GC.SuppressFinalize(this);
-        }
-
-        #endregion
-    }
-
-    public class Stbi
-    {
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/> into <paramref name="dst"/>. Requires an additional copy
-        /// to <paramref name="dst"/> and is thus slower than <see cref="LoadFromMemory"/>.
-        /// </summary>
-        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
-        /// <param name="len">Number of bytes that the encoded image data is long.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
-        /// image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
-        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</param>
-        /// <returns>True on success, false on failure.</returns>
-        [DllImport("stbi")]
-        unsafe public static extern bool LoadFromMemoryIntoBuffer(byte* data, long len, int desiredNumChannels, byte* dst);
-
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/> into <paramref name="dst"/>. Requires an additional copy
-        /// to <paramref name="dst"/> and is thus slower than <see cref="LoadFromMemory"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data to be loaded.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
-        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
-        /// N bytes where N is the number of channels, ordered RGBA.</param>
-        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
-        unsafe public static void LoadFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int desiredNumChannels, Span<byte> dst)
-        {
-            fixed (byte* address = data)
-            fixed (byte* dstAddress = dst)
-                if (!LoadFromMemoryIntoBuffer(address, data.Length, desiredNumChannels, dstAddress))
-                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
-        }
-
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/> into <paramref name="dst"/>. Requires an additional copy
-        /// to <paramref name="dst"/> and is thus slower than <see cref="LoadFromMemory"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data to be loaded.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
-        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
-        /// N bytes where N is the number of channels, ordered RGBA.</param>
-        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
-        public static void LoadFromMemoryInfoBuffer(MemoryStream data, int desiredNumChannels, Span<byte> dst) =>
-            LoadFromMemoryIntoBuffer(data.GetBuffer(), desiredNumChannels, dst);
-
-        /// <summary>
-        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
-        /// <param name="len">Number of bytes that the encoded image data is long.</param>
-        /// <param name="width">The number of pixels the image is wide.</param>
-        /// <param name="height">The number of pixels the image is tall.</param>
-        /// <param name="numChannels">The number of colour channels of the image.</param>
-        /// <returns>True on success, false on failure.</returns>
-        [DllImport("stbi")]
-        unsafe public static extern bool InfoFromMemory(byte* data, long len, out int width, out int height, out int numChannels);
-
-        /// <summary>
-        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data.</param>
-        /// <param name="width">The number of pixels the image is wide.</param>
-        /// <param name="height">The number of pixels the image is tall.</param>
-        /// <param name="numChannels">The number of colour channels of the image.</param>
-        /// <exception cref="ArgumentException">Thrown when image metadata loading fails.</exception>
-        unsafe public static void InfoFromMemory(ReadOnlySpan<byte> data, out int width, out int height, out int numChannels)
-        {
-            fixed (byte* address = data)
-                if (!InfoFromMemory(address, data.Length, out width, out height, out numChannels))
-                    throw new ArgumentException($"STBI could not load image metadata from the provided {nameof(data)}: {FailureReason()}");
-        }
-
-        /// <summary>
-        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data.</param>
-        /// <param name="width">The number of pixels the image is wide.</param>
-        /// <param name="height">The number of pixels the image is tall.</param>
-        /// <param name="numChannels">The number of colour channels of the image.</param>
-        /// <exception cref="ArgumentException">Thrown when image metadata loading fails.</exception>
-        public static void InfoFromMemory(MemoryStream data, out int width, out int height, out int numChannels)
-            => InfoFromMemory(data.GetBuffer(), out width, out height, out numChannels);
-
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
-        /// <param name="len">Number of bytes that the encoded image data is long.</param>
-        /// <param name="width">The number of pixels the image is wide.</param>
-        /// <param name="height">The number of pixels the image is tall.</param>
-        /// <param name="numChannels">The number of colour channels of the image.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
-        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
-        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</returns>
-        [DllImport("stbi")]
-        unsafe public static extern byte* LoadFromMemory(byte* data, long len, out int width, out int height, out int numChannels, int desiredNumChannels);
-
-        /// <summary>
-        /// Flip the image vertically, so the first pixel in the output array is the bottom left.
-        /// </summary>
-        /// <param name="shouldFlip">True if should flip vertically on load.</param>
-        [DllImport("stbi")]
-        unsafe public static extern void SetFlipVerticallyOnLoad(bool shouldFlip);
-
-        /// <summary>
-        /// Frees memory of an image that has previously been loaded by <see cref="LoadFromMemory"/>. Only
-        /// has to be called when the byte-pointer overload of <see cref="LoadFromMemory"/> was used.
-        /// </summary>
-        /// <param name="data">Pointer to the beginning of the pixel data.</param>
-        [DllImport("stbi")]
-        unsafe public static extern void Free(byte* data);
-
-        /// <summary>
-        /// After failure to load an image, returns a pointer to a string describing the reason for the failure.
-        /// </summary>
-        [DllImport("stbi", EntryPoint = "FailureReason")]
-        unsafe public static extern IntPtr FailureReasonIntPtr();
-
-        /// <summary>
-        /// After failure to load an image, returns a string describing the reason for the failure.
-        /// </summary>
-        public static string FailureReason() => Marshal.PtrToStringAuto(FailureReasonIntPtr());
-
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data to be loaded.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
-        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
-        /// been allocated to store the image data.</returns>
-        unsafe public static StbiImage LoadFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels)
-        {
-            fixed (byte* address = data)
-            {
-                byte* pixels = LoadFromMemory(address, data.Length, out int width, out int height, out int numChannels, desiredNumChannels);
-                if (pixels == null)
-                {
-                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
-                }
-
-                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
-            }
-        }
-
-        /// <summary>
-        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
-        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
-        /// residing at <paramref name="data"/>.
-        /// </summary>
-        /// <param name="data">The encoded image data to be loaded.</param>
-        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
-        /// When the encoded image has fewer channels than the desired number of channels,
-        /// then the desired number of channels will be produced automatically. For example,
-        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
-        /// alpha channel will be generated. Supplying a value of 0 means that the native number
-        /// of channels of the encoded image is used.</param>
-        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
-        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
-        /// been allocated to store the image data.</returns>
-        public static StbiImage LoadFromMemory(MemoryStream data, int desiredNumChannels)
-            => LoadFromMemory(data.GetBuffer(), desiredNumChannels);
-    }
-}
+﻿// This file was developed by Thomas Müller <thomas94@gmx.net>.
+// It is published under the BSD 3-Clause License within the LICENSE file.
+
+using System;
+using System.Buffers;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.Diagnostics.Tracing;
+using System.IO;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace StbiSharp
+{
+    /// <summary>
+    /// A disposable class that exposes image data and metadata for images loaded via STBI.
+    /// On disposal, frees any native memory that has been allocated to store the image data.
+    /// </summary>
+    /// <typeparam name="T">The type of each channel: <see cref="byte"/> for 8-bit images,
+    /// <see cref="ushort"/> for 16-bit images, and <see cref="float"/> for HDR images.</typeparam>
+    unsafe public class StbiImage<T> : IMemoryOwner<T> where T : unmanaged
+    {
+        private protected T* data = null;
+        private protected long capacity = 0;
+        private protected StbiMemoryManager<T> memoryManager = null;
+
+        // Set for images whose data is shared with other images, which must therefore not be modified in place.
+        private protected bool shared = false;
+
+        /// <summary>
+        /// The width of the image in number of pixels.
+        /// </summary>
+        public int Width { get; private protected set; }
+
+        /// <summary>
+        /// The height of the image in number of pixels.
+        /// </summary>
+        public int Height { get; private protected set; }
+
+        /// <summary>
+        /// The number of colour channels of the image.
+        /// </summary>
+        public int NumChannels { get; private protected set; }
+
+        /// <summary>
+        /// The raw image data. It is stored in row-major order, pixel by pixel. Each pixel consists
+        /// of <see cref="NumChannels"/> values of type <typeparamref name="T"/> ordered RGBA.
+        /// </summary>
+        public ReadOnlySpan<T> Data => new ReadOnlySpan<T>(data, Width * Height * NumChannels);
+
+        /// <summary>
+        /// The raw image data as <see cref="Memory{T}"/>, such that it can be passed across <c>await</c>
+        /// boundaries and to APIs like <c>System.IO.Pipelines</c> without being copied. Refers to native
+        /// memory that is freed on disposal of this object, so it must not be used afterwards. The memory
+        /// is writable as required by <see cref="IMemoryOwner{T}"/>, but images returned by a
+        /// <see cref="StbiDecodeCache"/> share it, so it must not be written to for those. The memory keeps
+        /// this object from being finalized while it is in use.
+        /// </summary>
+        /// <exception cref="ObjectDisposedException">This image was already disposed.</exception>
+        public Memory<T> Memory
+        {
+            get
+            {
+                if (data == null)
+                    throw new ObjectDisposedException(GetType().Name);
+
+                if (memoryManager == null)
+                    memoryManager = new StbiMemoryManager<T>(this, data, Width * Height * NumChannels);
+
+                return memoryManager.Memory;
+            }
+        }
+
+        // Whether memory of the given manager still refers to the data of this image; disposal and reloading
+        // discard the manager.
+        internal bool Owns(StbiMemoryManager<T> manager) => data != null && memoryManager == manager;
+
+        internal StbiImage(T* data, int width, int height, int numChannels)
+        {
+            this.data = data;
+            capacity = (long)width * height * numChannels * sizeof(T);
+
+            Width = width;
+            Height = height;
+            NumChannels = numChannels;
+        }
+
+        #region IDisposable Support
+
+        protected virtual void Dispose(bool disposing)
+        {
+            if (data != null)
+            {
+                Stbi.Free((byte*)data);
+                data = null;
+            }
+        }
+
+        ~StbiImage()
+        {
+            Dispose(false);
+        }
+
+        public void Dispose()
+        {
+            Dispose(true);
+            memoryManager = null;
+            GC.SuppressFinalize(this);
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// Exposes the native memory of an image as <see cref="Memory{T}"/>. Native memory does not move, so pinning
+    /// is free. Holds on to the image, such that it is not finalized while the memory is in use.
+    /// </summary>
+    unsafe internal sealed class StbiMemoryManager<T> : MemoryManager<T> where T : unmanaged
+    {
+        private readonly StbiImage<T> owner;
+        private readonly T* pointer;
+        private readonly int length;
+
+        internal StbiMemoryManager(StbiImage<T> owner, T* pointer, int length)
+        {
+            this.owner = owner;
+            this.pointer = pointer;
+            this.length = length;
+        }
+
+        public override Span<T> GetSpan()
+        {
+            ThrowIfDisposed();
+            return new Span<T>(pointer, length);
+        }
+
+        // The handle refers to this manager, and thereby to the image, until it is disposed.
+        public override MemoryHandle Pin(int elementIndex = 0)
+        {
+            ThrowIfDisposed();
+            if (elementIndex < 0 || elementIndex > length)
+                throw new ArgumentOutOfRangeException(nameof(elementIndex));
+
+            return new MemoryHandle(pointer + elementIndex, default, this);
+        }
+
+        private void ThrowIfDisposed()
+        {
+            if (!owner.Owns(this))
+                throw new ObjectDisposedException(owner.GetType().Name);
+        }
+
+        public override void Unpin()
+        {
+        }
+
+        protected override void Dispose(bool disposing)
+        {
+        }
+    }
+
+    /// <summary>
+    /// Exposes the first <see cref="Memory"/>.Length elements of a pooled rental, which may be larger than requested.
+    /// Returns the rental to its pool on disposal.
+    /// </summary>
+    internal sealed class StbiPooledMemory<T> : IMemoryOwner<T>
+    {
+        private IMemoryOwner<T> rental;
+
+        public Memory<T> Memory { get; private set; }
+
+        internal StbiPooledMemory(IMemoryOwner<T> rental, int length)
+        {
+            this.rental = rental;
+            Memory = rental.Memory.Slice(0, length);
+        }
+
+        public void Dispose()
+        {
+            rental?.Dispose();
+            rental = null;
+            Memory = Memory<T>.Empty;
+        }
+    }
+
+    /// <summary>
+    /// A disposable class that exposes image data and metadata for 8-bit images loaded via STBI.
+    /// On disposal, frees any native memory that has been allocated to store the image data.
+    /// </summary>
+    unsafe public class StbiImage : StbiImage<byte>
+    {
+        internal StbiImage(byte* data, int width, int height, int numChannels) : base(data, width, height, numChannels)
+        {
+        }
+
+        // Transfers ownership of the pixels to the caller, leaving this image disposed.
+        internal byte* DetachData()
+        {
+            byte* pixels = data;
+            data = null;
+            memoryManager = null;
+            GC.SuppressFinalize(this);
+            return pixels;
+        }
+
+        /// <summary>
+        /// Decodes another image into this object, reusing its native buffer whenever the new image fits into it.
+        /// Only when the new image is larger is the buffer reallocated. Decoding many images of similar size through
+        /// a single <see cref="StbiImage"/> thereby avoids a native allocation, a native free, and a finalizable
+        /// object per image.
+        ///
+        /// <see cref="StbiImage{T}.Data"/> and <see cref="StbiImage{T}.Memory"/> obtained prior to this call must not be used afterwards.
+        /// On failure, the dimensions of the image remain unchanged, but the contents of its data are undefined.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <exception cref="ObjectDisposedException">This image was already disposed.</exception>
+        /// <exception cref="ArgumentException">The image could not be decoded.</exception>
+        /// <exception cref="InvalidOperationException">This image shares its data with other images,
+        /// because it was returned by a <see cref="StbiDecodeCache"/>.</exception>
+        public void Reload(ReadOnlySpan<byte> data, int desiredNumChannels)
+        {
+            if (this.data == null)
+                throw new ObjectDisposedException(nameof(StbiImage));
+
+            if (shared)
+                throw new InvalidOperationException("Images that are shared through a StbiDecodeCache cannot be reloaded.");
+
+            byte* pixels = this.data;
+            long newCapacity = capacity;
+            bool success;
+            int width, height, numChannels;
+            fixed (byte* dataPtr = data)
+            {
+                success = Stbi.ReloadFromMemory(dataPtr, data.Length, desiredNumChannels, &pixels, &newCapacity, &width, &height, &numChannels);
+            }
+
+            // The buffer may have been reallocated even if decoding failed afterwards.
+            this.data = pixels;
+            memoryManager = null;
+            capacity = newCapacity;
+
+            if (!success)
+                throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {Stbi.FailureReason()}");
+
+            Width = width;
+            Height = height;
+            NumChannels = desiredNumChannels == 0 ? numChannels : desiredNumChannels;
+        }
+    }
+
+    /// <summary>
+    /// The 64-bit variant of xxHash, a fast non-cryptographic hash. See https://github.com/Cyan4973/xxHash.
+    /// </summary>
+    internal static class StbiXxHash64
+    {
+        private const ulong Prime1 = 11400714785074694791UL;
+        private const ulong Prime2 = 14029467366897019727UL;
+        private const ulong Prime3 = 1609587929392839161UL;
+        private const ulong Prime4 = 9650029242287828579UL;
+        private const ulong Prime5 = 2870177450012600261UL;
+
+        private static ulong RotateLeft(ulong x, int r) => (x << r) | (x >> (64 - r));
+
+        private static ulong Round(ulong acc, ulong input) => RotateLeft(acc + input * Prime2, 31) * Prime1;
+
+        private static ulong Merge(ulong acc, ulong v) => (acc ^ Round(0, v)) * Prime1 + Prime4;
+
+        internal static ulong Hash(ReadOnlySpan<byte> data, ulong seed)
+        {
+            int i = 0;
+            ulong h;
+            if (data.Length >= 32)
+            {
+                ulong v1 = seed + Prime1 + Prime2, v2 = seed + Prime2, v3 = seed, v4 = seed - Prime1;
+                for (; i + 32 <= data.Length; i += 32)
+                {
+                    v1 = Round(v1, BinaryPrimitives.ReadUInt64LittleEndian(data.Slice(i)));
+                    v2 = Round(v2, BinaryPrimitives.ReadUInt64LittleEndian(data.Slice(i + 8)));
+                    v3 = Round(v3, BinaryPrimitives.ReadUInt64LittleEndian(data.Slice(i + 16)));
+                    v4 = Round(v4, BinaryPrimitives.ReadUInt64LittleEndian(data.Slice(i + 24)));
+                }
+
+                h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+                h = Merge(Merge(Merge(Merge(h, v1), v2), v3), v4);
+            }
+            else
+            {
+                h = seed + Prime5;
+            }
+
+            h += (ulong)data.Length;
+
+            for (; i + 8 <= data.Length; i += 8)
+                h = RotateLeft(h ^ Round(0, BinaryPrimitives.ReadUInt64LittleEndian(data.Slice(i))), 27) * Prime1 + Prime4;
+
+            if (i + 4 <= data.Length)
+            {
+                h = RotateLeft(h ^ (BinaryPrimitives.ReadUInt32LittleEndian(data.Slice(i)) * Prime1), 23) * Prime2 + Prime3;
+                i += 4;
+            }
+
+            for (; i < data.Length; ++i)
+                h = RotateLeft(h ^ (data[i] * Prime5), 11) * Prime1;
+
+            h ^= h >> 33;
+            h *= Prime2;
+            h ^= h >> 29;
+            h *= Prime3;
+            h ^= h >> 32;
+            return h;
+        }
+    }
+
+    /// <summary>
+    /// A decoded image that is held by a <see cref="StbiDecodeCache"/> and shared by all images that are returned
+    /// for it. Its pixels are freed once the cache evicted it and all of these images have been disposed.
+    /// </summary>
+    unsafe internal sealed class StbiCacheEntry
+    {
+        private int refCount = 1;
+
+        internal byte* Pixels { get; }
+        internal int Width { get; }
+        internal int Height { get; }
+        internal int NumChannels { get; }
+        internal long Size => (long)Width * Height * NumChannels;
+
+        internal StbiCacheEntry(byte* pixels, int width, int height, int numChannels)
+        {
+            Pixels = pixels;
+            Width = width;
+            Height = height;
+            NumChannels = numChannels;
+        }
+
+        internal void AddRef() => Interlocked.Increment(ref refCount);
+
+        // May be called from the finalizer thread by images that were not disposed.
+        internal void Release()
+        {
+            if (Interlocked.Decrement(ref refCount) == 0)
+                Stbi.Free(Pixels);
+        }
+    }
+
+    /// <summary>
+    /// An image returned by a <see cref="StbiDecodeCache"/>. Disposal releases its reference to the shared pixels.
+    /// </summary>
+    unsafe internal sealed class StbiCachedImage : StbiImage
+    {
+        private StbiCacheEntry entry;
+
+        internal StbiCachedImage(StbiCacheEntry entry) : base(entry.Pixels, entry.Width, entry.Height, entry.NumChannels)
+        {
+            this.entry = entry;
+            shared = true;
+        }
+
+        protected override void Dispose(bool disposing)
+        {
+            if (data != null)
+            {
+                data = null;
+                entry.Release();
+                entry = null;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Caches decoded images by a hash of their encoded data and load options, such that loading the same
+    /// encoded image again skips decoding. When the total size of the decoded images exceeds the budget,
+    /// the least recently loaded images are evicted. All members are thread-safe.
+    /// </summary>
+    /// <remarks>
+    /// Returned images share their pixels with the cache and with each other, and thus cannot be reloaded.
+    /// Their <see cref="StbiImage{T}.Memory"/> must not be written to either, because the writes would show
+    /// in every image that shares the pixels, including those of later loads. Each of them has to be disposed
+    /// independently; the pixels are freed once the cache evicted them and all images that share them have
+    /// been disposed. Keys are 64-bit xxHash digests along with the length of the encoded data, of which
+    /// accidental collisions are vanishingly unlikely, but which are not safe against adversarial inputs.
+    /// </remarks>
+    unsafe public sealed class StbiDecodeCache : IDisposable
+    {
+        private struct Key : IEquatable<Key>
+        {
+            public ulong Hash;
+            public long Length;
+            public StbiLoadOptions Options;
+
+            // BitsPerChannel is validated to be 0 or 8, which both mean 8 bits, and thus not compared.
+            public bool Equals(Key other) =>
+                Hash == other.Hash && Length == other.Length &&
+                Options.DesiredNumChannels == other.Options.DesiredNumChannels &&
+                Options.FlipVertically == other.Options.FlipVertically &&
+                Options.ChannelOrder == other.Options.ChannelOrder &&
+                Options.PremultiplyAlpha == other.Options.PremultiplyAlpha;
+
+            public override bool Equals(object obj) => obj is Key other && Equals(other);
+
+            public override int GetHashCode() => (int)Hash ^ (int)(Hash >> 32);
+        }
+
+        private readonly object mutex = new object();
+        private readonly Dictionary<Key, LinkedListNode<KeyValuePair<Key, StbiCacheEntry>>> entries = new Dictionary<Key, LinkedListNode<KeyValuePair<Key, StbiCacheEntry>>>();
+        // Most recently used first.
+        private readonly LinkedList<KeyValuePair<Key, StbiCacheEntry>> lru = new LinkedList<KeyValuePair<Key, StbiCacheEntry>>();
+
+        private long sizeBytes = 0;
+        private long hits = 0;
+        private long misses = 0;
+        private long evictions = 0;
+
+        /// <summary>
+        /// The maximum total size of the cached decoded images in bytes. Larger images are not cached at all.
+        /// </summary>
+        public long BudgetBytes { get; }
+
+        /// <summary>
+        /// The total size of the cached decoded images in bytes.
+        /// </summary>
+        public long SizeBytes { get { lock (mutex) return sizeBytes; } }
+
+        /// <summary>
+        /// The number of cached images.
+        /// </summary>
+        public int Count { get { lock (mutex) return entries.Count; } }
+
+        /// <summary>
+        /// The number of loads that were served from the cache.
+        /// </summary>
+        public long Hits => Interlocked.Read(ref hits);
+
+        /// <summary>
+        /// The number of loads that had to decode.
+        /// </summary>
+        public long Misses => Interlocked.Read(ref misses);
+
+        /// <summary>
+        /// The number of images that were evicted to stay within <see cref="BudgetBytes"/>.
+        /// </summary>
+        public long Evictions => Interlocked.Read(ref evictions);
+
+        /// <summary>
+        /// Creates an empty cache.
+        /// </summary>
+        /// <param name="budgetBytes">The maximum total size of the cached decoded images in bytes.</param>
+        public StbiDecodeCache(long budgetBytes)
+        {
+            if (budgetBytes < 0)
+                throw new ArgumentOutOfRangeException(nameof(budgetBytes));
+
+            BudgetBytes = budgetBytes;
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>, or returns the cached result of an earlier load of the
+        /// same data with the same number of desired channels.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata, and that has to be disposed independently of the cache.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        public StbiImage LoadFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels) =>
+            LoadFromMemory(data, new StbiLoadOptions { DesiredNumChannels = desiredNumChannels });
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>, or returns the cached result of an earlier load of the
+        /// same data with the same options.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata, and that has to be disposed independently of the cache.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails, or when <paramref name="options"/>
+        /// requests a bit depth other than 8.</exception>
+        public StbiImage LoadFromMemory(ReadOnlySpan<byte> data, StbiLoadOptions options)
+        {
+            // Checked ahead of the lookup, such that other bit depths are not served 8-bit images from the cache.
+            if (options.BitsPerChannel != 0 && options.BitsPerChannel != 8)
+                throw new ArgumentException($"Only 8 bits per channel can be loaded into a StbiImage. Use {nameof(Stbi.Load16FromMemory)} or {nameof(Stbi.LoadFFromMemory)} for other bit depths.", nameof(options));
+
+            var key = new Key { Hash = StbiXxHash64.Hash(data, 0), Length = data.Length, Options = options };
+            lock (mutex)
+            {
+                if (entries.TryGetValue(key, out var node))
+                {
+                    Interlocked.Increment(ref hits);
+                    lru.Remove(node);
+                    lru.AddFirst(node);
+                    return Share(node.Value.Value);
+                }
+            }
+
+            Interlocked.Increment(ref misses);
+
+            // Decoding happens outside the lock, such that misses on different images do not serialize. Should
+            // another thread have inserted the same image in the meantime, its copy is used instead.
+            var image = Stbi.LoadFromMemory(data, options);
+            if (image.Width * (long)image.Height * image.NumChannels > BudgetBytes)
+                return image;
+
+            var entry = new StbiCacheEntry(image.DetachData(), image.Width, image.Height, image.NumChannels);
+
+            lock (mutex)
+            {
+                if (entries.TryGetValue(key, out var node))
+                {
+                    entry.Release();
+                    lru.Remove(node);
+                    lru.AddFirst(node);
+                    return Share(node.Value.Value);
+                }
+
+                entries.Add(key, lru.AddFirst(new KeyValuePair<Key, StbiCacheEntry>(key, entry)));
+                sizeBytes += entry.Size;
+                while (sizeBytes > BudgetBytes)
+                {
+                    Interlocked.Increment(ref evictions);
+                    Evict(lru.Last);
+                }
+
+                return Share(entry);
+            }
+        }
+
+        /// <summary>
+        /// Evicts all images. Images that were returned by the cache remain valid until they are disposed.
+        /// </summary>
+        public void Clear()
+        {
+            lock (mutex)
+            {
+                while (lru.Last != null)
+                    Evict(lru.Last);
+            }
+        }
+
+        /// <summary>
+        /// Evicts all images. Images that were returned by the cache remain valid until they are disposed.
+        /// </summary>
+        public void Dispose() => Clear();
+
+        private static StbiImage Share(StbiCacheEntry entry)
+        {
+            entry.AddRef();
+            return new StbiCachedImage(entry);
+        }
+
+        private void Evict(LinkedListNode<KeyValuePair<Key, StbiCacheEntry>> node)
+        {
+            lru.Remove(node);
+            entries.Remove(node.Value.Key);
+            sizeBytes -= node.Value.Value.Size;
+            node.Value.Value.Release();
+        }
+    }
+
+    /// <summary>
+    /// Function pointers through which STBI pulls encoded image data from a source other than memory.
+    /// Mirrors <c>stbi_io_callbacks</c> of stb_image.h.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StbiIoCallbacks
+    {
+        /// <summary>
+        /// Pointer to a <see cref="StbiReadCallback"/>.
+        /// </summary>
+        public IntPtr Read;
+
+        /// <summary>
+        /// Pointer to a <see cref="StbiSkipCallback"/>.
+        /// </summary>
+        public IntPtr Skip;
+
+        /// <summary>
+        /// Pointer to a <see cref="StbiEofCallback"/>.
+        /// </summary>
+        public IntPtr Eof;
+    }
+
+    /// <summary>
+    /// Fills <paramref name="data"/> with at most <paramref name="size"/> bytes and returns the number of bytes
+    /// that were actually read.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    unsafe public delegate int StbiReadCallback(IntPtr user, byte* data, int size);
+
+    /// <summary>
+    /// Skips the next <paramref name="n"/> bytes, or un-reads the last -<paramref name="n"/> bytes if negative.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void StbiSkipCallback(IntPtr user, int n);
+
+    /// <summary>
+    /// Returns nonzero if the end of the data has been reached.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate int StbiEofCallback(IntPtr user);
+
+    /// <summary>
+    /// The reasons for which STBI can fail to load an image.
+    /// </summary>
+    public enum StbiError
+    {
+        /// <summary>
+        /// No error occurred.
+        /// </summary>
+        Ok = 0,
+
+        /// <summary>
+        /// An argument that was passed to STBI is invalid.
+        /// </summary>
+        InvalidArgument = 1,
+
+        /// <summary>
+        /// The data is not in any of the supported formats.
+        /// </summary>
+        UnknownFormat = 2,
+
+        /// <summary>
+        /// The data is corrupt or truncated.
+        /// </summary>
+        Corrupt = 3,
+
+        /// <summary>
+        /// The data uses a feature of its format that is not supported.
+        /// </summary>
+        Unsupported = 4,
+
+        /// <summary>
+        /// Not enough memory could be allocated.
+        /// </summary>
+        OutOfMemory = 5,
+
+        /// <summary>
+        /// The image is too large to be loaded.
+        /// </summary>
+        TooLarge = 6,
+
+        /// <summary>
+        /// A file could not be opened or read.
+        /// </summary>
+        Io = 7,
+
+        /// <summary>
+        /// The load was cancelled before it completed.
+        /// </summary>
+        Cancelled = 8,
+    }
+
+    /// <summary>
+    /// Per-call options for loading images. Unlike <see cref="Stbi.SetFlipVerticallyOnLoad"/>, these options
+    /// only affect the load they are passed to, such that threads can load with different options concurrently.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StbiLoadOptions
+    {
+        /// <summary>
+        /// The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.
+        /// </summary>
+        public int DesiredNumChannels;
+
+        private int flipVertically;
+
+        /// <summary>
+        /// Flip the image vertically, so the first pixel in the output array is the bottom left.
+        /// </summary>
+        public bool FlipVertically
+        {
+            get => flipVertically != 0;
+            set => flipVertically = value ? 1 : 0;
+        }
+
+        /// <summary>
+        /// The number of bits per channel of the output: 8 or 16 for unsigned integer channels, or 32 for
+        /// float channels. Supplying a value of 0 means 8 bits per channel.
+        /// </summary>
+        public int BitsPerChannel;
+
+        /// <summary>
+        /// The memory order of the channels of 3- and 4-channel output. Anything but <see cref="StbiChannelOrder.Rgba"/>
+        /// requires 8 bits per channel.
+        /// </summary>
+        public StbiChannelOrder ChannelOrder;
+
+        private int premultiplyAlpha;
+
+        /// <summary>
+        /// Multiply the colour channels by alpha, as expected by most GPU upload paths and compositors.
+        /// Requires 8 bits per channel.
+        /// </summary>
+        public bool PremultiplyAlpha
+        {
+            get => premultiplyAlpha != 0;
+            set => premultiplyAlpha = value ? 1 : 0;
+        }
+
+        /// <summary>
+        /// The number of threads on which to decode and convert a single large image. Values below 2 use
+        /// only the calling thread. Baseline JPEGs with restart markers are decoded in bands of MCU rows in
+        /// parallel; other images are decoded on the calling thread, and only the channel conversion is split.
+        /// </summary>
+        public int NumThreads;
+    }
+
+    /// <summary>
+    /// The memory order of the channels of loaded pixels. Applied by the native library in the same pass
+    /// that premultiplies alpha, so loaded images need not be swizzled afterwards.
+    /// </summary>
+    public enum StbiChannelOrder
+    {
+        /// <summary>
+        /// Red, green, blue, alpha. This is the order that STBI produces by default.
+        /// </summary>
+        Rgba = 0,
+
+        /// <summary>
+        /// Blue, green, red, alpha. 3-channel output is ordered blue, green, red.
+        /// </summary>
+        Bgra = 1,
+
+        /// <summary>
+        /// Alpha, red, green, blue. 3-channel output remains ordered red, green, blue.
+        /// </summary>
+        Argb = 2,
+    }
+
+    /// <summary>
+    /// The type of the values of planar output. See <see cref="StbiPlanarOptions"/>.
+    /// </summary>
+    public enum StbiPlanarFormat
+    {
+        /// <summary>
+        /// 8-bit unsigned integers.
+        /// </summary>
+        Uint8 = 0,
+
+        /// <summary>
+        /// 32-bit floats, of which each is <c>v * Scale[c] + Bias[c]</c> for the 8-bit value <c>v</c> of channel <c>c</c>.
+        /// </summary>
+        Float = 1,
+    }
+
+    /// <summary>
+    /// Options for planar output, which stores all values of channel c, row by row, before those of channel c + 1,
+    /// as expected by tensors in CHW layout.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    unsafe public struct StbiPlanarOptions
+    {
+        /// <summary>
+        /// The type of the output values.
+        /// </summary>
+        public StbiPlanarFormat Format;
+
+        /// <summary>
+        /// The factor by which the 8-bit values of each channel are multiplied for <see cref="StbiPlanarFormat.Float"/> output.
+        /// </summary>
+        public fixed float Scale[4];
+
+        /// <summary>
+        /// The offset that is added to the scaled values of each channel for <see cref="StbiPlanarFormat.Float"/> output.
+        /// </summary>
+        public fixed float Bias[4];
+
+        /// <summary>
+        /// Options for planar output of 8-bit values.
+        /// </summary>
+        public static StbiPlanarOptions Uint8 => new StbiPlanarOptions { Format = StbiPlanarFormat.Uint8 };
+
+        /// <summary>
+        /// Options for planar float output, where each value is first mapped to [0, 1] and then normalized by the
+        /// mean and standard deviation of its channel, e.g. those of a neural network's training data.
+        /// </summary>
+        /// <param name="mean">The mean of each channel in [0, 1]. Missing channels have a mean of 0.</param>
+        /// <param name="std">The standard deviation of each channel in [0, 1]. Missing channels have a
+        /// standard deviation of 1.</param>
+        public static StbiPlanarOptions Normalized(ReadOnlySpan<float> mean, ReadOnlySpan<float> std)
+        {
+            if (mean.Length > 4 || std.Length > 4)
+                throw new ArgumentException("Images have at most 4 channels.");
+
+            var options = new StbiPlanarOptions { Format = StbiPlanarFormat.Float };
+            for (int c = 0; c < 4; ++c)
+            {
+                float m = c < mean.Length ? mean[c] : 0;
+                float s = c < std.Length ? std[c] : 1;
+                options.Scale[c] = 1 / (255 * s);
+                options.Bias[c] = -m / s;
+            }
+
+            return options;
+        }
+    }
+
+    /// <summary>
+    /// Allocates <paramref name="size"/> bytes on behalf of STBI. See <see cref="Stbi.SetAllocator"/>.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate IntPtr StbiMallocCallback(UIntPtr size, IntPtr user);
+
+    /// <summary>
+    /// Frees memory that has been allocated by a <see cref="StbiMallocCallback"/>. See <see cref="Stbi.SetAllocator"/>.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void StbiFreeCallback(IntPtr p, IntPtr user);
+
+    /// <summary>
+    /// Statistics of STBI's allocator, aggregated over all threads.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StbiAllocatorStats
+    {
+        /// <summary>
+        /// The total number of allocations.
+        /// </summary>
+        public long NumAllocations;
+
+        /// <summary>
+        /// The number of allocations that were served from the arena of the allocating thread rather than by the host.
+        /// </summary>
+        public long NumArenaHits;
+
+        /// <summary>
+        /// The number of bytes that are currently allocated, either by decoders or by loaded images that have not
+        /// been freed yet.
+        /// </summary>
+        public long NumLiveBytes;
+
+        /// <summary>
+        /// The highest number of bytes that have been allocated at the same time. Every thread accounts for
+        /// its allocations in steps of 64 KiB, so short spikes below that may be missed.
+        /// </summary>
+        public long NumPeakLiveBytes;
+
+        /// <summary>
+        /// The number of freed bytes that arenas hold on to for reuse.
+        /// </summary>
+        public long NumRetainedBytes;
+    }
+
+    /// <summary>
+    /// Formats by which <see cref="StbiStats"/> are broken down, as identified by their signatures.
+    /// Formats without a signature, such as TGA, count as <see cref="Other"/>.
+    /// </summary>
+    public enum StbiFormat
+    {
+        /// <summary>JPEG.</summary>
+        Jpeg = 0,
+        /// <summary>PNG.</summary>
+        Png = 1,
+        /// <summary>BMP.</summary>
+        Bmp = 2,
+        /// <summary>GIF.</summary>
+        Gif = 3,
+        /// <summary>Photoshop PSD.</summary>
+        Psd = 4,
+        /// <summary>Radiance HDR.</summary>
+        Hdr = 5,
+        /// <summary>Binary PGM and PPM.</summary>
+        Pnm = 6,
+        /// <summary>Softimage PIC.</summary>
+        Pic = 7,
+        /// <summary>TGA and any other format.</summary>
+        Other = 8,
+    }
+
+    /// <summary>
+    /// Decode statistics of a single format, aggregated over all threads since they were last reset.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StbiFormatStats
+    {
+        /// <summary>
+        /// The number of decodes, including failed ones.
+        /// </summary>
+        public long NumDecodes;
+
+        /// <summary>
+        /// The number of decodes that failed.
+        /// </summary>
+        public long NumFailures;
+
+        /// <summary>
+        /// The number of encoded bytes that were passed to decodes.
+        /// </summary>
+        public long NumBytesIn;
+
+        /// <summary>
+        /// The number of decoded bytes that successful decodes produced.
+        /// </summary>
+        public long NumBytesOut;
+
+        /// <summary>
+        /// Nanoseconds spent parsing headers.
+        /// </summary>
+        public long HeaderNanoseconds;
+
+        /// <summary>
+        /// Nanoseconds spent decoding pixels. stb_image does not expose its internal stages, so this covers
+        /// entropy decoding, IDCT, and colour conversion of JPEGs as well as inflating and unfiltering PNGs.
+        /// </summary>
+        public long DecodeNanoseconds;
+
+        /// <summary>
+        /// Nanoseconds spent converting decoded pixels: reordering channels, premultiplying alpha, and scaling.
+        /// </summary>
+        public long PostNanoseconds;
+    }
+
+    /// <summary>
+    /// A snapshot of STBI's decode statistics. See <see cref="Stbi.GetStats()"/>.
+    /// </summary>
+    public sealed class StbiStats
+    {
+        /// <summary>
+        /// The statistics of each format, indexed by <see cref="StbiFormat"/>.
+        /// </summary>
+        public StbiFormatStats[] Formats { get; }
+
+        /// <summary>
+        /// The highest number of bytes that STBI had allocated at the same time since statistics were last reset.
+        /// </summary>
+        public long PeakLiveBytes { get; }
+
+        /// <summary>
+        /// The statistics of <paramref name="format"/>.
+        /// </summary>
+        public StbiFormatStats this[StbiFormat format] => Formats[(int)format];
+
+        /// <summary>
+        /// The statistics of all formats combined.
+        /// </summary>
+        public StbiFormatStats Total
+        {
+            get
+            {
+                var total = new StbiFormatStats();
+                foreach (var f in Formats)
+                {
+                    total.NumDecodes += f.NumDecodes;
+                    total.NumFailures += f.NumFailures;
+                    total.NumBytesIn += f.NumBytesIn;
+                    total.NumBytesOut += f.NumBytesOut;
+                    total.HeaderNanoseconds += f.HeaderNanoseconds;
+                    total.DecodeNanoseconds += f.DecodeNanoseconds;
+                    total.PostNanoseconds += f.PostNanoseconds;
+                }
+
+                return total;
+            }
+        }
+
+        internal StbiStats(StbiFormatStats[] formats, long peakLiveBytes)
+        {
+            Formats = formats;
+            PeakLiveBytes = peakLiveBytes;
+        }
+    }
+
+    /// <summary>
+    /// Publishes STBI's decode statistics to EventPipe and ETW listeners, e.g. <c>dotnet-counters monitor StbiSharp</c>.
+    /// Enabling this event source enables STBI's statistics (see <see cref="Stbi.SetStatsEnabled(bool)"/>), which are
+    /// otherwise off. On .NET Core 3.0, the statistics of all formats combined are published as event counters;
+    /// on all targets, <see cref="WriteStats"/> publishes the statistics of each format as events.
+    /// </summary>
+    [EventSource(Name = "StbiSharp")]
+    public sealed class StbiEventSource : EventSource
+    {
+        /// <summary>
+        /// The single instance of this event source.
+        /// </summary>
+        public static readonly StbiEventSource Log = new StbiEventSource();
+
+#if NETCOREAPP3_0
+        private DiagnosticCounter[] counters = null;
+#endif
+
+        private StbiEventSource()
+        {
+        }
+
+        /// <summary>
+        /// Enables STBI's statistics once a listener enables this event source.
+        /// </summary>
+        protected override void OnEventCommand(EventCommandEventArgs command)
+        {
+            if (command.Command != EventCommand.Enable)
+                return;
+
+            Stbi.SetStatsEnabled(true);
+
+#if NETCOREAPP3_0
+            if (counters != null)
+                return;
+
+            counters = new DiagnosticCounter[]
+            {
+                new IncrementingPollingCounter("decodes", this, () => Stbi.GetStats().Total.NumDecodes) { DisplayName = "Decodes", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("failures", this, () => Stbi.GetStats().Total.NumFailures) { DisplayName = "Failed decodes", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("bytes-in", this, () => Stbi.GetStats().Total.NumBytesIn) { DisplayName = "Encoded bytes", DisplayUnits = "B", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("bytes-out", this, () => Stbi.GetStats().Total.NumBytesOut) { DisplayName = "Decoded bytes", DisplayUnits = "B", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("header-time", this, () => Stbi.GetStats().Total.HeaderNanoseconds / 1e6) { DisplayName = "Header time", DisplayUnits = "ms", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("decode-time", this, () => Stbi.GetStats().Total.DecodeNanoseconds / 1e6) { DisplayName = "Decode time", DisplayUnits = "ms", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new IncrementingPollingCounter("post-time", this, () => Stbi.GetStats().Total.PostNanoseconds / 1e6) { DisplayName = "Post-processing time", DisplayUnits = "ms", DisplayRateTimeScale = TimeSpan.FromSeconds(1) },
+                new PollingCounter("peak-memory", this, () => Stbi.GetStats().PeakLiveBytes / 1e6) { DisplayName = "Peak allocated memory", DisplayUnits = "MB" },
+            };
+#endif
+        }
+
+        /// <summary>
+        /// Writes one <see cref="FormatStats"/> event per format that was decoded at least once since statistics
+        /// were last reset. Does nothing unless a listener enabled this event source.
+        /// </summary>
+        [NonEvent]
+        public void WriteStats()
+        {
+            if (!IsEnabled())
+                return;
+
+            var stats = Stbi.GetStats();
+            for (int i = 0; i < stats.Formats.Length; ++i)
+            {
+                var f = stats.Formats[i];
+                if (f.NumDecodes > 0)
+                    FormatStats(((StbiFormat)i).ToString(), f.NumDecodes, f.NumFailures, f.NumBytesIn, f.NumBytesOut, f.HeaderNanoseconds / 1e6, f.DecodeNanoseconds / 1e6, f.PostNanoseconds / 1e6);
+            }
+        }
+
+        /// <summary>
+        /// The decode statistics of a single format. See <see cref="StbiFormatStats"/>.
+        /// </summary>
+        [Event(1, Level = EventLevel.Informational)]
+        public void FormatStats(string format, long numDecodes, long numFailures, long numBytesIn, long numBytesOut, double headerMilliseconds, double decodeMilliseconds, double postMilliseconds)
+            => WriteEvent(1, format, numDecodes, numFailures, numBytesIn, numBytesOut, headerMilliseconds, decodeMilliseconds, postMilliseconds);
+    }
+
+    /// <summary>
+    /// Describes one image of a <see cref="Stbi.LoadBatch(StbiBatchItem*, long, int)"/> call. The fields up to
+    /// and including <see cref="DstLen"/> are inputs; the remaining fields are outputs.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    unsafe public struct StbiBatchItem
+    {
+        /// <summary>
+        /// Pointer to the beginning of the encoded image data.
+        /// </summary>
+        public byte* Data;
+
+        /// <summary>
+        /// Number of bytes that the encoded image data is long.
+        /// </summary>
+        public long Len;
+
+        /// <summary>
+        /// The number of desired colour channels in the output. Supplying a value of 0 means that the native
+        /// number of channels of the encoded image is used.
+        /// </summary>
+        public int DesiredNumChannels;
+
+        /// <summary>
+        /// Pointer to the beginning of the destination buffer into which the image is loaded. When null, a buffer
+        /// is allocated for the image and stored here. It has to be freed by <see cref="Stbi.Free"/>.
+        /// </summary>
+        public byte* Dst;
+
+        /// <summary>
+        /// Number of bytes that <see cref="Dst"/> is long. Images that do not fit fail with
+        /// <see cref="StbiError.InvalidArgument"/>. Ignored when <see cref="Dst"/> is null.
+        /// </summary>
+        public long DstLen;
+
+        /// <summary>
+        /// The number of pixels the image is wide.
+        /// </summary>
+        public int Width;
+
+        /// <summary>
+        /// The number of pixels the image is tall.
+        /// </summary>
+        public int Height;
+
+        /// <summary>
+        /// The number of colour channels of the encoded image.
+        /// </summary>
+        public int NumChannels;
+
+        /// <summary>
+        /// <see cref="StbiError.Ok"/> on success, otherwise the reason for the failure.
+        /// </summary>
+        public StbiError Status;
+
+        /// <summary>
+        /// On failure, a pointer to a string describing the reason for the failure.
+        /// </summary>
+        public IntPtr FailureReason;
+    }
+
+    /// <summary>
+    /// Describes one image of a <see cref="Stbi.InfoBatch(StbiInfoItem*, long, int)"/> call. The fields up to
+    /// and including <see cref="Len"/> are inputs; the remaining fields are outputs.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    unsafe public struct StbiInfoItem
+    {
+        /// <summary>
+        /// Pointer to the beginning of the encoded image data.
+        /// </summary>
+        public byte* Data;
+
+        /// <summary>
+        /// Number of bytes that the encoded image data is long.
+        /// </summary>
+        public long Len;
+
+        /// <summary>
+        /// The number of pixels the image is wide.
+        /// </summary>
+        public int Width;
+
+        /// <summary>
+        /// The number of pixels the image is tall.
+        /// </summary>
+        public int Height;
+
+        /// <summary>
+        /// The number of colour channels of the encoded image.
+        /// </summary>
+        public int NumChannels;
+
+        /// <summary>
+        /// The number of bits per channel of the encoded image: 8 or 16 for unsigned integer channels,
+        /// or 32 for HDR images, whose channels are natively float.
+        /// </summary>
+        public int BitsPerChannel;
+
+        private int isHdr;
+
+        /// <summary>
+        /// Whether the image is HDR, such that it is best loaded by <see cref="Stbi.LoadFFromMemory(ReadOnlySpan{byte}, int)"/>.
+        /// </summary>
+        public bool IsHdr => isHdr != 0;
+
+        /// <summary>
+        /// <see cref="StbiError.Ok"/> on success, otherwise the reason for the failure.
+        /// </summary>
+        public StbiError Status;
+
+        /// <summary>
+        /// On failure, a pointer to a string describing the reason for the failure.
+        /// </summary>
+        public IntPtr FailureReason;
+    }
+
+    /// <summary>
+    /// Feeds encoded image data from a <see cref="Stream"/> to STBI through a small, fixed-size buffer.
+    /// </summary>
+    unsafe internal sealed class StbiStreamReader
+    {
+        private const int BufferSize = 4096;
+
+        private static readonly StbiReadCallback ReadDelegate = Read;
+        private static readonly StbiSkipCallback SkipDelegate = Skip;
+        private static readonly StbiEofCallback EofDelegate = Eof;
+
+        internal static readonly StbiIoCallbacks Callbacks = new StbiIoCallbacks
+        {
+            Read = Marshal.GetFunctionPointerForDelegate(ReadDelegate),
+            Skip = Marshal.GetFunctionPointerForDelegate(SkipDelegate),
+            Eof = Marshal.GetFunctionPointerForDelegate(EofDelegate),
+        };
+
+        private readonly Stream stream;
+        private readonly byte[] buffer = new byte[BufferSize];
+        private int bufferPos = 0;
+        private int bufferLen = 0;
+
+        // Exceptions must not propagate through native frames. They are stored instead and rethrown once
+        // control has returned to managed code.
+        private ExceptionDispatchInfo exception = null;
+
+        internal StbiStreamReader(Stream stream)
+        {
+            this.stream = stream;
+        }
+
+        internal void ThrowIfFailed()
+        {
+            exception?.Throw();
+        }
+
+        private bool Refill()
+        {
+            bufferPos = 0;
+            bufferLen = stream.Read(buffer, 0, buffer.Length);
+            return bufferLen > 0;
+        }
+
+        private static StbiStreamReader FromUser(IntPtr user) => (StbiStreamReader)GCHandle.FromIntPtr(user).Target;
+
+        private static int Read(IntPtr user, byte* data, int size)
+        {
+            var self = FromUser(user);
+            if (self.exception != null)
+                return 0;
+
+            try
+            {
+                int total = 0;
+                while (total < size)
+                {
+                    if (self.bufferPos == self.bufferLen && !self.Refill())
+                        break;
+
+                    int n = Math.Min(size - total, self.bufferLen - self.bufferPos);
+                    new ReadOnlySpan<byte>(self.buffer, self.bufferPos, n).CopyTo(new Span<byte>(data + total, n));
+                    self.bufferPos += n;
+                    total += n;
+                }
+
+                return total;
+            }
+            catch (Exception e)
+            {
+                self.exception = ExceptionDispatchInfo.Capture(e);
+                return 0;
+            }
+        }
+
+        private static void Skip(IntPtr user, int n)
+        {
+            var self = FromUser(user);
+            if (self.exception != null)
+                return;
+
+            try
+            {
+                int buffered = self.bufferLen - self.bufferPos;
+                if (n >= -self.bufferPos && n <= buffered)
+                {
+                    self.bufferPos += n;
+                    return;
+                }
+
+                if (self.stream.CanSeek)
+                {
+                    self.stream.Seek(n - buffered, SeekOrigin.Current);
+                    self.bufferPos = self.bufferLen = 0;
+                    return;
+                }
+
+                n -= buffered;
+                self.bufferPos = self.bufferLen = 0;
+                while (n > 0 && self.Refill())
+                {
+                    int skipped = Math.Min(n, self.bufferLen);
+                    self.bufferPos = skipped;
+                    n -= skipped;
+                }
+            }
+            catch (Exception e)
+            {
+                self.exception = ExceptionDispatchInfo.Capture(e);
+            }
+        }
+
+        private static int Eof(IntPtr user)
+        {
+            var self = FromUser(user);
+            if (self.exception != null)
+                return 1;
+
+            try
+            {
+                return self.bufferPos == self.bufferLen && !self.Refill() ? 1 : 0;
+            }
+            catch (Exception e)
+            {
+                self.exception = ExceptionDispatchInfo.Capture(e);
+                return 1;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Receives <paramref name="numRows"/> consecutive rows of pixels, of which the first is row <paramref name="y"/>
+    /// of an image of size <paramref name="width"/> x <paramref name="height"/>. Returning nonzero stops the delivery
+    /// of further rows. See <see cref="Stbi.LoadRowsFromMemory(byte*, long, int, int, IntPtr, IntPtr)"/>.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    unsafe public delegate int StbiRowCallback(IntPtr user, int y, int numRows, byte* rows, int width, int height, int numChannels);
+
+    /// <summary>
+    /// Consumes a loaded image band by band. See <see cref="Stbi.LoadRowsFromMemory(ReadOnlySpan{byte}, int, IStbiRowSink, int)"/>
+    /// for which images are decoded without ever being held in memory as a whole.
+    /// </summary>
+    public interface IStbiRowSink
+    {
+        /// <summary>
+        /// Called once before the first rows are delivered.
+        /// </summary>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of each delivered pixel.</param>
+        void Begin(int width, int height, int numChannels);
+
+        /// <summary>
+        /// Called with consecutive bands of rows, from top to bottom.
+        /// </summary>
+        /// <param name="y">The index of the first row of the band.</param>
+        /// <param name="rows">The rows of the band in row-major order, pixel by pixel. Each pixel consists
+        /// of N bytes where N is the number of channels, ordered RGBA. Only valid during the call.</param>
+        /// <returns>True to continue with the next band, false to stop.</returns>
+        bool WriteRows(int y, ReadOnlySpan<byte> rows);
+    }
+
+    /// <summary>
+    /// Forwards rows from STBI to an <see cref="IStbiRowSink"/>.
+    /// </summary>
+    unsafe internal sealed class StbiRowSinkAdapter
+    {
+        private static readonly StbiRowCallback RowDelegate = WriteRows;
+
+        internal static readonly IntPtr Callback = Marshal.GetFunctionPointerForDelegate(RowDelegate);
+
+        private readonly IStbiRowSink sink;
+
+        // Exceptions must not propagate through native frames. They are stored instead and rethrown once
+        // control has returned to managed code.
+        private ExceptionDispatchInfo exception = null;
+
+        internal StbiRowSinkAdapter(IStbiRowSink sink)
+        {
+            this.sink = sink;
+        }
+
+        internal void ThrowIfFailed()
+        {
+            exception?.Throw();
+        }
+
+        private static int WriteRows(IntPtr user, int y, int numRows, byte* rows, int width, int height, int numChannels)
+        {
+            var self = (StbiRowSinkAdapter)GCHandle.FromIntPtr(user).Target;
+            try
+            {
+                if (y == 0)
+                    self.sink.Begin(width, height, numChannels);
+
+                return self.sink.WriteRows(y, new ReadOnlySpan<byte>(rows, numRows * width * numChannels)) ? 0 : 1;
+            }
+            catch (Exception e)
+            {
+                self.exception = ExceptionDispatchInfo.Capture(e);
+                return 1;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Receives the next <paramref name="size"/> bytes of an encoded image. Returning nonzero stops the delivery
+    /// of further bytes, which fails the write. See <see cref="Stbi.WritePngToMemory(byte*, int, int, int, long, int, IntPtr, IntPtr)"/>.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    unsafe public delegate int StbiWriteCallback(IntPtr user, byte* data, int size);
+
+    /// <summary>
+    /// Forwards encoded image data from STBI to an <see cref="IBufferWriter{T}"/> or a <see cref="Stream"/>.
+    /// </summary>
+    unsafe internal sealed class StbiWriterAdapter
+    {
+        private const int BufferSize = 4096;
+
+        private static readonly StbiWriteCallback WriteDelegate = Write;
+
+        internal static readonly IntPtr Callback = Marshal.GetFunctionPointerForDelegate(WriteDelegate);
+
+        private readonly IBufferWriter<byte> writer;
+        private readonly Stream stream;
+        private byte[] buffer;
+
+        // Exceptions must not propagate through native frames. They are stored instead and rethrown once
+        // control has returned to managed code.
+        private ExceptionDispatchInfo exception = null;
+
+        internal StbiWriterAdapter(IBufferWriter<byte> writer)
+        {
+            this.writer = writer;
+        }
+
+        internal StbiWriterAdapter(Stream stream)
+        {
+            this.stream = stream;
+        }
+
+        internal void ThrowIfFailed()
+        {
+            exception?.Throw();
+        }
+
+        private static int Write(IntPtr user, byte* data, int size)
+        {
+            var self = (StbiWriterAdapter)GCHandle.FromIntPtr(user).Target;
+            try
+            {
+                var source = new ReadOnlySpan<byte>(data, size);
+                if (self.writer != null)
+                {
+                    source.CopyTo(self.writer.GetSpan(size));
+                    self.writer.Advance(size);
+                    return 0;
+                }
+
+                // Not all target frameworks can write spans to streams, so the data is staged in a small buffer.
+                if (self.buffer == null)
+                    self.buffer = new byte[BufferSize];
+
+                while (source.Length > 0)
+                {
+                    int n = Math.Min(source.Length, self.buffer.Length);
+                    source.Slice(0, n).CopyTo(self.buffer);
+                    self.stream.Write(self.buffer, 0, n);
+                    source = source.Slice(n);
+                }
+
+                return 0;
+            }
+            catch (Exception e)
+            {
+                self.exception = ExceptionDispatchInfo.Capture(e);
+                return 1;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Receives the outcome of <see cref="Stbi.LoadAsync(byte*, long, StbiLoadOptions*, int*, IntPtr, IntPtr)"/>
+    /// on one of STBI's worker threads. On success, <paramref name="pixels"/> points to an image that has to be
+    /// released by <see cref="Stbi.Free(byte*)"/>; otherwise, it is null.
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    unsafe public delegate void StbiLoadCallback(IntPtr user, void* pixels, int width, int height, int numChannels, StbiError status, IntPtr failureReason);
+
+    /// <summary>
+    /// A load on STBI's worker pool that completes a task once STBI invokes its callback.
+    /// </summary>
+    unsafe internal sealed class StbiAsyncLoad
+    {
+        private static readonly StbiLoadCallback CompleteDelegate = Complete;
+
+        private static readonly IntPtr Callback = Marshal.GetFunctionPointerForDelegate(CompleteDelegate);
+
+        // Read by STBI while the load runs, so it lives in native memory rather than on the managed heap.
+        [StructLayout(LayoutKind.Sequential)]
+        private struct NativeState
+        {
+            public StbiLoadOptions Options;
+            public int Cancelled;
+        }
+
+        private readonly TaskCompletionSource<StbiImage> completion = new TaskCompletionSource<StbiImage>(TaskCreationOptions.RunContinuationsAsynchronously);
+        private readonly SemaphoreSlim slots;
+        private readonly CancellationToken cancellationToken;
+        private MemoryHandle dataHandle;
+        private NativeState* state;
+        private CancellationTokenRegistration registration;
+
+        internal Task<StbiImage> Task => completion.Task;
+
+        internal StbiAsyncLoad(SemaphoreSlim slots, CancellationToken cancellationToken)
+        {
+            this.slots = slots;
+            this.cancellationToken = cancellationToken;
+        }
+
+        internal void Start(ReadOnlyMemory<byte> data, StbiLoadOptions options)
+        {
+            var handle = GCHandle.Alloc(this);
+            try
+            {
+                dataHandle = data.Pin();
+                state = (NativeState*)Marshal.AllocHGlobal(sizeof(NativeState));
+                state->Options = options;
+                state->Cancelled = 0;
+
+                // Loads that can be cancelled are decoded serially, so only those pass the flag.
+                int* cancelled = null;
+                if (cancellationToken.CanBeCanceled)
+                {
+                    cancelled = &state->Cancelled;
+                    registration = cancellationToken.Register(() => *cancelled = 1);
+                }
+
+                if (!Stbi.LoadAsync((byte*)dataHandle.Pointer, data.Length, &state->Options, cancelled, Callback, GCHandle.ToIntPtr(handle)))
+                    throw new ArgumentException($"STBI could not queue the load: {Stbi.FailureReason()}");
+            }
+            catch
+            {
+                handle.Free();
+                Release();
+                throw;
+            }
+        }
+
+        private void Release()
+        {
+            registration.Dispose();
+            dataHandle.Dispose();
+            if (state != null)
+            {
+                Marshal.FreeHGlobal((IntPtr)state);
+                state = null;
+            }
+
+            // Release runs on the native worker thread, which must not run the continuation of the next load, as
+            // SemaphoreSlim may do inline: that load would wait for the worker to take it off the queue.
+            ThreadPool.QueueUserWorkItem(s => ((SemaphoreSlim)s).Release(), slots);
+        }
+
+        private static void Complete(IntPtr user, void* pixels, int width, int height, int numChannels, StbiError status, IntPtr failureReason)
+        {
+            var handle = GCHandle.FromIntPtr(user);
+            var self = (StbiAsyncLoad)handle.Target;
+            handle.Free();
+
+            // Exceptions must not propagate through native frames, so they fault the task instead.
+            try
+            {
+                int desiredNumChannels = self.state->Options.DesiredNumChannels;
+                self.Release();
+
+                if (pixels != null)
+                    self.completion.TrySetResult(new StbiImage((byte*)pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels));
+                else if (status == StbiError.Cancelled)
+                    self.completion.TrySetCanceled(self.cancellationToken);
+                else
+                    self.completion.TrySetException(new ArgumentException($"STBI could not load an image from the provided data: {Marshal.PtrToStringAnsi(failureReason)}"));
+            }
+            catch (Exception e)
+            {
+                if (pixels != null && !self.completion.Task.IsCompleted)
+                    Stbi.Free((byte*)pixels);
+
+                self.completion.TrySetException(e);
+            }
+        }
+    }
+
+    /// <summary>
+    /// A single frame of an animated image.
+    /// </summary>
+    public sealed class StbiFrame
+    {
+        /// <summary>
+        /// The index of the frame within the animation.
+        /// </summary>
+        public int Index { get; }
+
+        /// <summary>
+        /// The width of the frame in number of pixels.
+        /// </summary>
+        public int Width { get; }
+
+        /// <summary>
+        /// The height of the frame in number of pixels.
+        /// </summary>
+        public int Height { get; }
+
+        /// <summary>
+        /// The number of colour channels of the frame.
+        /// </summary>
+        public int NumChannels { get; }
+
+        /// <summary>
+        /// How long the frame is shown, in milliseconds.
+        /// </summary>
+        public int DelayMilliseconds { get; }
+
+        /// <summary>
+        /// The fully composited frame. It is stored in row-major order, pixel by pixel. Each pixel consists
+        /// of <see cref="NumChannels"/> bytes ordered RGBA.
+        /// </summary>
+        public ReadOnlyMemory<byte> Data { get; }
+
+        internal StbiFrame(int index, int width, int height, int numChannels, int delayMilliseconds, byte[] data)
+        {
+            Index = index;
+            Width = width;
+            Height = height;
+            NumChannels = numChannels;
+            DelayMilliseconds = delayMilliseconds;
+            Data = data;
+        }
+    }
+
+    /// <summary>
+    /// Describes one level of a mip chain within the buffer that holds the entire chain.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StbiMipLevel
+    {
+        /// <summary>
+        /// The offset of the level from the beginning of the buffer in bytes.
+        /// </summary>
+        public long Offset;
+
+        /// <summary>
+        /// The width of the level in number of pixels.
+        /// </summary>
+        public int Width;
+
+        /// <summary>
+        /// The height of the level in number of pixels.
+        /// </summary>
+        public int Height;
+    }
+
+    /// <summary>
+    /// A disposable class that exposes an 8-bit image along with all of its mip levels, which are stored one after
+    /// another in a single native buffer. On disposal, frees the buffer.
+    /// </summary>
+    unsafe public sealed class StbiMipChain : IDisposable
+    {
+        private byte* data;
+        private readonly long size;
+
+        /// <summary>
+        /// The levels of the chain, starting with the full-size image. Each level is half the size of the previous
+        /// one, rounded down.
+        /// </summary>
+        public StbiMipLevel[] Levels { get; }
+
+        /// <summary>
+        /// The number of colour channels of each level.
+        /// </summary>
+        public int NumChannels { get; }
+
+        /// <summary>
+        /// The entire chain, e.g. to be uploaded to the GPU at once.
+        /// </summary>
+        public ReadOnlySpan<byte> Data => new ReadOnlySpan<byte>(data, (int)size);
+
+        /// <summary>
+        /// A single level of the chain. It is stored in row-major order, pixel by pixel. Each pixel consists
+        /// of <see cref="NumChannels"/> bytes ordered RGBA.
+        /// </summary>
+        /// <param name="level">The index of the level, where 0 is the full-size image.</param>
+        public ReadOnlySpan<byte> Level(int level) =>
+            new ReadOnlySpan<byte>(data + Levels[level].Offset, Levels[level].Width * Levels[level].Height * NumChannels);
+
+        internal StbiMipChain(byte* data, long size, StbiMipLevel[] levels, int numChannels)
+        {
+            this.data = data;
+            this.size = size;
+            Levels = levels;
+            NumChannels = numChannels;
+        }
+
+        #region IDisposable Support
+
+        private void Dispose(bool disposing)
+        {
+            if (data != null)
+            {
+                Stbi.Free(data);
+                data = null;
+            }
+        }
+
+        ~StbiMipChain()
+        {
+            Dispose(false);
+        }
+
+        public void Dispose()
+        {
+            Dispose(true);
+            GC.SuppressFinalize(this);
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// The progress of a <see cref="StbiDecoder"/>.
+    /// </summary>
+    public enum StbiDecoderState
+    {
+        /// <summary>
+        /// More data is needed before anything is known about the image.
+        /// </summary>
+        NeedsData = 0,
+
+        /// <summary>
+        /// The dimensions and number of channels of the image are known, but its pixels are not decoded yet.
+        /// </summary>
+        HeaderAvailable = 1,
+
+        /// <summary>
+        /// The image has been decoded.
+        /// </summary>
+        Complete = 2,
+
+        /// <summary>
+        /// The image could not be decoded.
+        /// </summary>
+        Failed = 3,
+    }
+
+    /// <summary>
+    /// Decodes an image whose encoded data arrives piece by piece, for example from the network. The dimensions of
+    /// the image become available as soon as its header has arrived. PNG and JPEG images are decoded as soon as
+    /// their last byte has arrived; all other formats once <see cref="Finish"/> is called. Fed data is copied, so
+    /// buffers can be released or reused right after they were passed to <see cref="Feed"/>.
+    /// </summary>
+    unsafe public sealed class StbiDecoder : IDisposable
+    {
+        private IntPtr decoder;
+        private readonly int desiredNumChannels;
+
+        /// <summary>
+        /// The progress of decoding.
+        /// </summary>
+        public StbiDecoderState State { get; private set; } = StbiDecoderState.NeedsData;
+
+        /// <summary>
+        /// Creates a decoder.
+        /// </summary>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        public StbiDecoder(int desiredNumChannels)
+        {
+            this.desiredNumChannels = desiredNumChannels;
+            decoder = Stbi.CreateDecoder(desiredNumChannels);
+            if (decoder == IntPtr.Zero)
+                throw new OutOfMemoryException($"STBI could not create a decoder: {Stbi.FailureReason()}");
+        }
+
+        /// <summary>
+        /// Appends encoded data. Data that is fed after the image has been decoded is ignored.
+        /// </summary>
+        /// <param name="data">The next piece of the encoded image data.</param>
+        /// <returns>The progress of decoding after the data was appended.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        public StbiDecoderState Feed(ReadOnlySpan<byte> data)
+        {
+            fixed (byte* address = data)
+                return Update(Stbi.FeedDecoder(Handle, address, data.Length));
+        }
+
+        /// <summary>
+        /// Signals that all data has been fed, such that images whose end cannot be detected are decoded.
+        /// </summary>
+        /// <returns>The progress of decoding, which is either <see cref="StbiDecoderState.Complete"/> or
+        /// <see cref="StbiDecoderState.Failed"/>.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        public StbiDecoderState Finish() => Update(Stbi.FinishDecoder(Handle));
+
+        /// <summary>
+        /// Retrieves the dimensions and number of colour channels of the image, if its header has arrived.
+        /// </summary>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the encoded image.</param>
+        /// <returns>True if the header has arrived, false otherwise.</returns>
+        public bool TryGetInfo(out int width, out int height, out int numChannels) =>
+            Stbi.DecoderInfo(Handle, out width, out height, out numChannels);
+
+        /// <summary>
+        /// The number of rows of <see cref="Rows"/>.
+        /// </summary>
+        public int NumCompletedRows
+        {
+            get
+            {
+                Stbi.DecoderRows(Handle, out int numRows);
+                return numRows;
+            }
+        }
+
+        /// <summary>
+        /// The rows of pixels that have been decoded so far. They are stored in row-major order, pixel by pixel.
+        /// Each pixel consists of N bytes where N is the number of channels, ordered RGBA. The data is owned
+        /// by the decoder and must not be used after its disposal.
+        /// </summary>
+        public ReadOnlySpan<byte> Rows
+        {
+            get
+            {
+                byte* pixels = Stbi.DecoderRows(Handle, out int numRows);
+                if (numRows == 0 || !TryGetInfo(out int width, out int _, out int numChannels))
+                    return ReadOnlySpan<byte>.Empty;
+
+                return new ReadOnlySpan<byte>(pixels, width * numRows * (desiredNumChannels == 0 ? numChannels : desiredNumChannels));
+            }
+        }
+
+        private IntPtr Handle
+        {
+            get
+            {
+                if (decoder == IntPtr.Zero)
+                    throw new ObjectDisposedException(nameof(StbiDecoder));
+
+                return decoder;
+            }
+        }
+
+        private StbiDecoderState Update(StbiDecoderState state)
+        {
+            State = state;
+            if (state == StbiDecoderState.Failed)
+                throw new ArgumentException($"STBI could not decode the fed data: {Stbi.FailureReason()}");
+
+            return state;
+        }
+
+        #region IDisposable Support
+
+        private void Dispose(bool disposing)
+        {
+            if (decoder != IntPtr.Zero)
+            {
+                Stbi.DestroyDecoder(decoder);
+                decoder = IntPtr.Zero;
+            }
+        }
+
+        ~StbiDecoder()
+        {
+            Dispose(false);
+        }
+
+        public void Dispose()
+        {
+            Dispose(true);
+            GC.SuppressFinalize(this);
+        }
+
+        #endregion
+    }
+
+    public class Stbi
+    {
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadFromMemoryIntoBuffer(byte* data, long len, int desiredNumChannels, byte* dst);
+
+        /// <summary>
+        /// Loads an image from encoded data in memory into <paramref name="pixels"/>, a buffer that was previously
+        /// allocated by STBI and is <paramref name="capacity"/> bytes large. The buffer is reused if the decoded image
+        /// fits. Otherwise, it is freed and replaced by a larger one, in which case both <paramref name="pixels"/> and
+        /// <paramref name="capacity"/> are updated. If <paramref name="pixels"/> points to null, a new buffer is allocated.
+        /// The buffer must eventually be freed by <see cref="Free"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="len">The length of the encoded image data in bytes.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="pixels">The buffer to decode into. Updated if it needs to be reallocated.</param>
+        /// <param name="capacity">The size of the buffer in bytes. Updated if it needs to be reallocated.</param>
+        /// <param name="width">Output: the width of the image.</param>
+        /// <param name="height">Output: the height of the image.</param>
+        /// <param name="numChannels">Output: the number of channels of the encoded image.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool ReloadFromMemory(byte* data, long len, int desiredNumChannels, byte** pixels, long* capacity, int* width, int* height, int* numChannels);
+
+        /// <summary>
+        /// Loads a downscaled version of an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the downscaled image is stored in the output.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="scaleDenominator">The factor by which the image is downscaled. Each block of
+        /// <paramref name="scaleDenominator"/> x <paramref name="scaleDenominator"/> pixels is averaged into one pixel,
+        /// so an image of size W x H becomes ceil(W / <paramref name="scaleDenominator"/>) x
+        /// ceil(H / <paramref name="scaleDenominator"/>) pixels large.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// downscaled image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long. Images that do not fit
+        /// fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadScaledFromMemoryIntoBuffer(byte* data, long len, int scaleDenominator, int desiredNumChannels, byte* dst, long dstLen);
+
+        /// <summary>
+        /// Loads a downscaled version of an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the downscaled image is stored in the output.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="scaleDenominator">The factor by which the image is downscaled. Each block of
+        /// <paramref name="scaleDenominator"/> x <paramref name="scaleDenominator"/> pixels is averaged into one pixel,
+        /// so an image of size W x H becomes ceil(W / <paramref name="scaleDenominator"/>) x
+        /// ceil(H / <paramref name="scaleDenominator"/>) pixels large.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the downscaled image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadScaledFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int scaleDenominator, int desiredNumChannels, Span<byte> dst)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadScaledFromMemoryIntoBuffer(address, data.Length, scaleDenominator, desiredNumChannels, dstAddress, dst.Length))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads a downscaled version of an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the downscaled image is stored in the output.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="scaleDenominator">The factor by which the image is downscaled. Each block of
+        /// <paramref name="scaleDenominator"/> x <paramref name="scaleDenominator"/> pixels is averaged into one pixel,
+        /// so an image of size W x H becomes ceil(W / <paramref name="scaleDenominator"/>) x
+        /// ceil(H / <paramref name="scaleDenominator"/>) pixels large.</param>
+        /// <param name="width">The number of pixels the downscaled image is wide.</param>
+        /// <param name="height">The number of pixels the downscaled image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// downscaled image was loaded. The buffer must be freed by <see cref="Free"/>.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadScaledFromMemory(byte* data, long len, int scaleDenominator, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads a downscaled version of an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the downscaled image is stored in the output.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="scaleDenominator">The factor by which the image is downscaled. Each block of
+        /// <paramref name="scaleDenominator"/> x <paramref name="scaleDenominator"/> pixels is averaged into one pixel,
+        /// so an image of size W x H becomes ceil(W / <paramref name="scaleDenominator"/>) x
+        /// ceil(H / <paramref name="scaleDenominator"/>) pixels large.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage LoadScaledFromMemory(ReadOnlySpan<byte> data, int scaleDenominator, int desiredNumChannels)
+        {
+            fixed (byte* address = data)
+            {
+                byte* pixels = LoadScaledFromMemory(address, data.Length, scaleDenominator, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/> in planar layout, i.e. all
+        /// values of the first channel, row by row, followed by those of the second channel, and so on.
+        /// The decoded pixels are split into planes, and optionally converted to normalized floats, in a
+        /// single pass while they are still in cache.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <param name="planar">The type of the output values.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer, which must hold
+        /// width * height * N values of the type given by <paramref name="planar"/>.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadPlanarFromMemoryIntoBuffer(byte* data, long len, ref StbiLoadOptions options, ref StbiPlanarOptions planar, void* dst, long dstLen, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/> in planar layout, i.e. all
+        /// values of the first channel, row by row, followed by those of the second channel, and so on.
+        /// The decoded pixels are split into planes in a single pass while they are still in cache.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <param name="dst">The destination buffer, which must hold width * height * N bytes.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails, or when <paramref name="dst"/> is too small.</exception>
+        unsafe public static void LoadPlanarFromMemoryIntoBuffer(ReadOnlySpan<byte> data, StbiLoadOptions options, Span<byte> dst)
+        {
+            var planar = StbiPlanarOptions.Uint8;
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadPlanarFromMemoryIntoBuffer(address, data.Length, ref options, ref planar, dstAddress, dst.Length, out _, out _, out _))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/> as floats in planar layout,
+        /// i.e. all values of the first channel, row by row, followed by those of the second channel, and
+        /// so on. The decoded pixels are split into planes and converted in a single pass while they are
+        /// still in cache.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <param name="planar">The scale and bias of each channel, e.g. from <see cref="StbiPlanarOptions.Normalized"/>.
+        /// Its <see cref="StbiPlanarOptions.Format"/> is ignored.</param>
+        /// <param name="dst">The destination buffer, which must hold width * height * N floats.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails, or when <paramref name="dst"/> is too small.</exception>
+        unsafe public static void LoadPlanarFromMemoryIntoBuffer(ReadOnlySpan<byte> data, StbiLoadOptions options, StbiPlanarOptions planar, Span<float> dst)
+        {
+            planar.Format = StbiPlanarFormat.Float;
+            fixed (byte* address = data)
+            fixed (float* dstAddress = dst)
+                if (!LoadPlanarFromMemoryIntoBuffer(address, data.Length, ref options, ref planar, dstAddress, (long)dst.Length * sizeof(float), out _, out _, out _))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// The maximum number of levels of a mip chain, which is reached by images that are 2^31 - 1 pixels wide or tall.
+        /// </summary>
+        public const int MaxMipLevels = 32;
+
+        /// <summary>
+        /// Computes where each level of the mip chain of an image is stored within a buffer that holds the entire
+        /// chain, as filled by <see cref="LoadMipChainFromMemoryIntoBuffer(byte*, long, int, bool, int, byte*, long, StbiMipLevel*, out int)"/>.
+        /// </summary>
+        /// <param name="width">The width of the full-size image in number of pixels.</param>
+        /// <param name="height">The height of the full-size image in number of pixels.</param>
+        /// <param name="numChannels">The number of colour channels of each level.</param>
+        /// <param name="maxLevels">The maximum number of levels, for which <paramref name="levels"/> must have room.</param>
+        /// <param name="levels">Pointer to the beginning of an array that receives the levels.</param>
+        /// <param name="numLevels">The number of levels of the chain.</param>
+        /// <returns>The size of the buffer in bytes.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern long MipChainLayout(int width, int height, int numChannels, int maxLevels, StbiMipLevel* levels, out int numLevels);
+
+        /// <summary>
+        /// Computes where each level of the mip chain of an image is stored within a buffer that holds the entire chain.
+        /// </summary>
+        /// <param name="width">The width of the full-size image in number of pixels.</param>
+        /// <param name="height">The height of the full-size image in number of pixels.</param>
+        /// <param name="numChannels">The number of colour channels of each level.</param>
+        /// <param name="maxLevels">The maximum number of levels. Supplying a value of 0 means that the chain
+        /// continues until both dimensions are 1.</param>
+        /// <param name="levels">The levels of the chain, starting with the full-size image.</param>
+        /// <returns>The size of the buffer in bytes.</returns>
+        unsafe public static long MipChainLayout(int width, int height, int numChannels, int maxLevels, out StbiMipLevel[] levels)
+        {
+            var buffer = new StbiMipLevel[maxLevels == 0 ? MaxMipLevels : maxLevels];
+            long size;
+            int numLevels;
+            fixed (StbiMipLevel* address = buffer)
+                size = MipChainLayout(width, height, numChannels, buffer.Length, address, out numLevels);
+
+            levels = new StbiMipLevel[numLevels];
+            Array.Copy(buffer, levels, numLevels);
+            return size;
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>, followed by its mip levels.
+        /// The full-size image is decoded directly into <paramref name="dst"/>, after which each level is
+        /// filtered from the previous one with a 2x2 box filter while the latter is still in cache.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="srgb">True to average colour channels in linear light, as is correct for sRGB-encoded images.
+        /// Alpha is always averaged as is.</param>
+        /// <param name="maxLevels">The maximum number of levels, for which <paramref name="levels"/> must have room.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer, whose layout is given by
+        /// <see cref="MipChainLayout(int, int, int, int, StbiMipLevel*, out int)"/>.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long.</param>
+        /// <param name="levels">Pointer to the beginning of an array that receives the levels.</param>
+        /// <param name="numLevels">The number of levels that were produced.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadMipChainFromMemoryIntoBuffer(byte* data, long len, int desiredNumChannels, bool srgb, int maxLevels, byte* dst, long dstLen, StbiMipLevel* levels, out int numLevels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>, followed by its mip levels.
+        /// The full-size image is decoded directly into <paramref name="dst"/>, after which each level is
+        /// filtered from the previous one with a 2x2 box filter while the latter is still in cache.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="srgb">True to average colour channels in linear light, as is correct for sRGB-encoded images.
+        /// Alpha is always averaged as is.</param>
+        /// <param name="maxLevels">The maximum number of levels. Supplying a value of 0 means that the chain
+        /// continues until both dimensions are 1.</param>
+        /// <param name="dst">The destination buffer, whose layout is given by
+        /// <see cref="MipChainLayout(int, int, int, int, out StbiMipLevel[])"/>.</param>
+        /// <returns>The levels that were produced.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails, or when <paramref name="dst"/> is too small.</exception>
+        unsafe public static StbiMipLevel[] LoadMipChainFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int desiredNumChannels, bool srgb, int maxLevels, Span<byte> dst)
+        {
+            var buffer = new StbiMipLevel[maxLevels == 0 ? MaxMipLevels : maxLevels];
+            int numLevels;
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+            fixed (StbiMipLevel* levelsAddress = buffer)
+                if (!LoadMipChainFromMemoryIntoBuffer(address, data.Length, desiredNumChannels, srgb, buffer.Length, dstAddress, dst.Length, levelsAddress, out numLevels))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+
+            var levels = new StbiMipLevel[numLevels];
+            Array.Copy(buffer, levels, numLevels);
+            return levels;
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into a newly allocated buffer, followed by its mip levels.
+        /// Each level is filtered from the previous one with a 2x2 box filter while the latter is still in cache.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="srgb">True to average colour channels in linear light, as is correct for sRGB-encoded images.
+        /// Alpha is always averaged as is.</param>
+        /// <param name="maxLevels">The maximum number of levels, for which <paramref name="levels"/> must have room.</param>
+        /// <param name="levels">Pointer to the beginning of an array that receives the levels.</param>
+        /// <param name="numLevels">The number of levels that were produced.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer that holds the
+        /// chain, which has to be released by <see cref="Free(byte*)"/>.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadMipChainFromMemory(byte* data, long len, int desiredNumChannels, bool srgb, int maxLevels, StbiMipLevel* levels, out int numLevels, out int numChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> along with its mip levels. Each level is filtered from
+        /// the previous one with a 2x2 box filter while the latter is still in cache.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="srgb">True to average colour channels in linear light, as is correct for sRGB-encoded images.
+        /// Alpha is always averaged as is.</param>
+        /// <param name="maxLevels">The maximum number of levels. Supplying a value of 0 means that the chain
+        /// continues until both dimensions are 1.</param>
+        /// <returns>Returns a disposable <see cref="StbiMipChain"/> object that exposes the levels. On disposal,
+        /// <see cref="StbiMipChain"/> frees any native memory that has been allocated to store them.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiMipChain LoadMipChainFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels, bool srgb, int maxLevels)
+        {
+            var buffer = new StbiMipLevel[maxLevels == 0 ? MaxMipLevels : maxLevels];
+            byte* chain;
+            int numLevels, numChannels;
+            fixed (byte* address = data)
+            fixed (StbiMipLevel* levelsAddress = buffer)
+                chain = LoadMipChainFromMemory(address, data.Length, desiredNumChannels, srgb, buffer.Length, levelsAddress, out numLevels, out numChannels);
+
+            if (chain == null)
+                throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+
+            var levels = new StbiMipLevel[numLevels];
+            Array.Copy(buffer, levels, numLevels);
+
+            numChannels = desiredNumChannels == 0 ? numChannels : desiredNumChannels;
+            var last = levels[numLevels - 1];
+            return new StbiMipChain(chain, last.Offset + (long)last.Width * last.Height * numChannels, levels, numChannels);
+        }
+
+        /// <summary>
+        /// Loads the rectangular region of width <paramref name="width"/> and height <paramref name="height"/>
+        /// whose top-left corner is at (<paramref name="x"/>, <paramref name="y"/>) out of an encoded image
+        /// (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the region is stored in the output. The region must lie
+        /// entirely within the image.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="x">The left edge of the region in pixels.</param>
+        /// <param name="y">The top edge of the region in pixels.</param>
+        /// <param name="width">The number of pixels the region is wide.</param>
+        /// <param name="height">The number of pixels the region is tall.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// region is loaded. The loaded region will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long. Images that do not fit
+        /// fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadRegionFromMemoryIntoBuffer(byte* data, long len, int x, int y, int width, int height, int desiredNumChannels, byte* dst, long dstLen);
+
+        /// <summary>
+        /// Loads the rectangular region of width <paramref name="width"/> and height <paramref name="height"/>
+        /// whose top-left corner is at (<paramref name="x"/>, <paramref name="y"/>) out of an encoded image
+        /// (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the region is stored in the output. The region must lie
+        /// entirely within the image.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="x">The left edge of the region in pixels.</param>
+        /// <param name="y">The top edge of the region in pixels.</param>
+        /// <param name="width">The number of pixels the region is wide.</param>
+        /// <param name="height">The number of pixels the region is tall.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the region is loaded. The loaded region
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadRegionFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int x, int y, int width, int height, int desiredNumChannels, Span<byte> dst)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadRegionFromMemoryIntoBuffer(address, data.Length, x, y, width, height, desiredNumChannels, dstAddress, dst.Length))
+                    throw new ArgumentException($"STBI could not load a region from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads the rectangular region of width <paramref name="width"/> and height <paramref name="height"/>
+        /// whose top-left corner is at (<paramref name="x"/>, <paramref name="y"/>) out of an encoded image
+        /// (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the region is stored in the output. The region must lie
+        /// entirely within the image.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="x">The left edge of the region in pixels.</param>
+        /// <param name="y">The top edge of the region in pixels.</param>
+        /// <param name="width">The number of pixels the region is wide.</param>
+        /// <param name="height">The number of pixels the region is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// region was loaded. The buffer must be freed by <see cref="Free"/>.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadRegionFromMemory(byte* data, long len, int x, int y, int width, int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads the rectangular region of width <paramref name="width"/> and height <paramref name="height"/>
+        /// whose top-left corner is at (<paramref name="x"/>, <paramref name="y"/>) out of an encoded image
+        /// (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Only the region is stored in the output. The region must lie
+        /// entirely within the image.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="x">The left edge of the region in pixels.</param>
+        /// <param name="y">The top edge of the region in pixels.</param>
+        /// <param name="width">The number of pixels the region is wide.</param>
+        /// <param name="height">The number of pixels the region is tall.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes the region's data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the region's data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage LoadRegionFromMemory(ReadOnlySpan<byte> data, int x, int y, int width, int height, int desiredNumChannels)
+        {
+            fixed (byte* address = data)
+            {
+                byte* pixels = LoadRegionFromMemory(address, data.Length, x, y, width, height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load a region from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int desiredNumChannels, Span<byte> dst)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadFromMemoryIntoBuffer(address, data.Length, desiredNumChannels, dstAddress))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        public static void LoadFromMemoryIntoBuffer(MemoryStream data, int desiredNumChannels, Span<byte> dst) =>
+            LoadFromMemoryIntoBuffer(WrittenData(data), desiredNumChannels, dst);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        [Obsolete("Use LoadFromMemoryIntoBuffer instead.")]
+        public static void LoadFromMemoryInfoBuffer(MemoryStream data, int desiredNumChannels, Span<byte> dst) =>
+            LoadFromMemoryIntoBuffer(data, desiredNumChannels, dst);
+
+        /// <summary>
+        /// Returns the bytes that have been written to <paramref name="stream"/>, excluding any unused capacity of
+        /// its underlying buffer, such that STBI does not parse trailing garbage.
+        /// </summary>
+        private static ReadOnlySpan<byte> WrittenData(MemoryStream stream)
+        {
+            if (stream.TryGetBuffer(out ArraySegment<byte> buffer))
+                return new ReadOnlySpan<byte>(buffer.Array, buffer.Offset, buffer.Count);
+
+            return stream.ToArray();
+        }
+
+        /// <summary>
+        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool InfoFromMemory(byte* data, long len, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <exception cref="ArgumentException">Thrown when image metadata loading fails.</exception>
+        unsafe public static void InfoFromMemory(ReadOnlySpan<byte> data, out int width, out int height, out int numChannels)
+        {
+            fixed (byte* address = data)
+                if (!InfoFromMemory(address, data.Length, out width, out height, out numChannels))
+                    throw new ArgumentException($"STBI could not load image metadata from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <exception cref="ArgumentException">Thrown when image metadata loading fails.</exception>
+        public static void InfoFromMemory(MemoryStream data, out int width, out int height, out int numChannels)
+            => InfoFromMemory(WrittenData(data), out width, out height, out numChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadFromMemory(byte* data, long len, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// from the file at <paramref name="path"/>. The file is memory-mapped and decoded directly
+        /// from the mapping.
+        /// </summary>
+        /// <param name="path">Pointer to the null-terminated, UTF-8 encoded path of the file.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadFromFile(byte* path, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// from the file at <paramref name="path"/>. The file is memory-mapped and decoded directly
+        /// from the mapping, such that the encoded image data never passes through the managed heap.
+        /// </summary>
+        /// <param name="path">The path of the file.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when opening the file or image loading fails.</exception>
+        unsafe public static StbiImage LoadFromFile(string path, int desiredNumChannels)
+        {
+            fixed (byte* address = NullTerminatedUtf8(path))
+            {
+                byte* pixels = LoadFromFile(address, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(path)}: {FailureReason()}");
+                }
+
+                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// in the file at <paramref name="path"/>.
+        /// </summary>
+        /// <param name="path">Pointer to the null-terminated, UTF-8 encoded path of the file.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool InfoFromFile(byte* path, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Retrieves metadata from an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// in the file at <paramref name="path"/>.
+        /// </summary>
+        /// <param name="path">The path of the file.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <exception cref="ArgumentException">Thrown when opening the file or image metadata loading fails.</exception>
+        unsafe public static void InfoFromFile(string path, out int width, out int height, out int numChannels)
+        {
+            fixed (byte* address = NullTerminatedUtf8(path))
+                if (!InfoFromFile(address, out width, out height, out numChannels))
+                    throw new ArgumentException($"STBI could not load image metadata from the provided {nameof(path)}: {FailureReason()}");
+        }
+
+        private static byte[] NullTerminatedUtf8(string str)
+        {
+            var bytes = new byte[Encoding.UTF8.GetByteCount(str) + 1];
+            Encoding.UTF8.GetBytes(str, 0, str.Length, bytes, 0);
+            return bytes;
+        }
+
+        /// <summary>
+        /// Reads the headers of a batch of encoded images on a pool of native threads, without decoding them.
+        /// Threads that run out of work steal images from the remaining work of other threads.
+        /// </summary>
+        /// <param name="items">Pointer to the beginning of an array of images to be probed. The outcome of probing
+        /// each image is stored in its respective item.</param>
+        /// <param name="numItems">The number of images to be probed.</param>
+        /// <param name="numThreads">The number of threads to probe the images on, including the calling thread.
+        /// Supplying a value of 0 means that one thread per hardware thread is used.</param>
+        [DllImport("stbi")]
+        unsafe public static extern void InfoBatch(StbiInfoItem* items, long numItems, int numThreads);
+
+        /// <summary>
+        /// Reads the headers of a batch of encoded images on a pool of native threads, without decoding them.
+        /// All images are pinned at once and probed in a single native call, which, unlike calling
+        /// <see cref="InfoFromMemory(ReadOnlySpan{byte}, out int, out int, out int)"/> per image, never throws
+        /// on bad inputs.
+        /// </summary>
+        /// <param name="data">The encoded images to be probed.</param>
+        /// <param name="numThreads">The number of threads to probe the images on, including the calling thread.
+        /// Supplying a value of 0 means that one thread per hardware thread is used.</param>
+        /// <returns>One item per element of <paramref name="data"/>. Its <see cref="StbiInfoItem.Status"/>
+        /// reports whether probing succeeded. Its <see cref="StbiInfoItem.Data"/> must not be dereferenced,
+        /// because the images are no longer pinned.</returns>
+        unsafe public static StbiInfoItem[] InfoBatch(ReadOnlyMemory<byte>[] data, int numThreads)
+        {
+            var items = new StbiInfoItem[data.Length];
+            var handles = new MemoryHandle[data.Length];
+            try
+            {
+                for (int i = 0; i < data.Length; ++i)
+                {
+                    handles[i] = data[i].Pin();
+                    items[i].Data = (byte*)handles[i].Pointer;
+                    items[i].Len = data[i].Length;
+                }
+
+                fixed (StbiInfoItem* address = items)
+                    InfoBatch(address, items.Length, numThreads);
+            }
+            finally
+            {
+                foreach (var handle in handles)
+                    handle.Dispose();
+            }
+
+            return items;
+        }
+
+        /// <summary>
+        /// Loads a batch of encoded images (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats) on a pool of
+        /// native threads. Threads that run out of work steal images from the remaining work of other threads.
+        /// </summary>
+        /// <param name="items">Pointer to the beginning of an array of images to be loaded. The outcome of loading
+        /// each image is stored in its respective item.</param>
+        /// <param name="numItems">The number of images to be loaded.</param>
+        /// <param name="numThreads">The number of threads to load the images on, including the calling thread.
+        /// Supplying a value of 0 means that one thread per hardware thread is used.</param>
+        [DllImport("stbi")]
+        unsafe public static extern void LoadBatch(StbiBatchItem* items, long numItems, int numThreads);
+
+        /// <summary>
+        /// Loads a batch of encoded images (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats) on a pool of
+        /// native threads. Threads that run out of work steal images from the remaining work of other threads.
+        /// </summary>
+        /// <param name="data">The encoded images to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="numThreads">The number of threads to load the images on, including the calling thread.
+        /// Supplying a value of 0 means that one thread per hardware thread is used.</param>
+        /// <returns>Returns one disposable <see cref="StbiImage"/> object per element of <paramref name="data"/>,
+        /// or null for each element that could not be loaded.</returns>
+        unsafe public static StbiImage[] LoadBatch(ReadOnlyMemory<byte>[] data, int desiredNumChannels, int numThreads)
+        {
+            var items = new StbiBatchItem[data.Length];
+            var handles = new MemoryHandle[data.Length];
+            try
+            {
+                for (int i = 0; i < data.Length; ++i)
+                {
+                    handles[i] = data[i].Pin();
+                    items[i].Data = (byte*)handles[i].Pointer;
+                    items[i].Len = data[i].Length;
+                    items[i].DesiredNumChannels = desiredNumChannels;
+                }
+
+                fixed (StbiBatchItem* address = items)
+                    LoadBatch(address, items.Length, numThreads);
+            }
+            finally
+            {
+                foreach (var handle in handles)
+                    handle.Dispose();
+            }
+
+            var images = new StbiImage[data.Length];
+            for (int i = 0; i < data.Length; ++i)
+            {
+                if (items[i].Status == StbiError.Ok)
+                    images[i] = new StbiImage(items[i].Dst, items[i].Width, items[i].Height, desiredNumChannels == 0 ? items[i].NumChannels : desiredNumChannels);
+            }
+
+            return images;
+        }
+
+        /// <summary>
+        /// Loads a batch of encoded images (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats) into
+        /// <paramref name="dst"/> on a pool of native threads. Threads that run out of work steal images
+        /// from the remaining work of other threads.
+        /// </summary>
+        /// <param name="data">The encoded images to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">One destination buffer per element of <paramref name="data"/>. Each image
+        /// will be stored in its buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N bytes where N is the number of channels, ordered RGBA. Images that do not fit into their
+        /// buffer fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <param name="numThreads">The number of threads to load the images on, including the calling thread.
+        /// Supplying a value of 0 means that one thread per hardware thread is used.</param>
+        /// <returns>Returns for each element of <paramref name="data"/> <see cref="StbiError.Ok"/> if it was
+        /// loaded successfully, otherwise the reason for the failure.</returns>
+        unsafe public static StbiError[] LoadBatch(ReadOnlyMemory<byte>[] data, int desiredNumChannels, Memory<byte>[] dst, int numThreads)
+        {
+            if (dst.Length != data.Length)
+                throw new ArgumentException("The number of destination buffers must match the number of images.", nameof(dst));
+
+            var items = new StbiBatchItem[data.Length];
+            var handles = new MemoryHandle[2 * data.Length];
+            try
+            {
+                for (int i = 0; i < data.Length; ++i)
+                {
+                    if (dst[i].IsEmpty)
+                        throw new ArgumentException("Destination buffers must not be empty.", nameof(dst));
+
+                    handles[2 * i] = data[i].Pin();
+                    handles[2 * i + 1] = dst[i].Pin();
+                    items[i].Data = (byte*)handles[2 * i].Pointer;
+                    items[i].Len = data[i].Length;
+                    items[i].DesiredNumChannels = desiredNumChannels;
+                    items[i].Dst = (byte*)handles[2 * i + 1].Pointer;
+                    items[i].DstLen = dst[i].Length;
+                }
+
+                fixed (StbiBatchItem* address = items)
+                    LoadBatch(address, items.Length, numThreads);
+            }
+            finally
+            {
+                foreach (var handle in handles)
+                    handle.Dispose();
+            }
+
+            var errors = new StbiError[data.Length];
+            for (int i = 0; i < data.Length; ++i)
+                errors[i] = items[i].Status;
+
+            return errors;
+        }
+
+        /// <summary>
+        /// Replaces the pool of native worker threads on which <see cref="LoadAsync(ReadOnlyMemory{byte}, StbiLoadOptions, CancellationToken)"/>
+        /// decodes. Returns without waiting for the previous pool, on which loads that are already queued still
+        /// complete. May be called from the completion of a load.
+        /// </summary>
+        /// <param name="numThreads">The number of worker threads. Supplying a value of 0 means that one thread per
+        /// hardware thread is used.</param>
+        /// <param name="queueCapacity">The number of loads that can wait for a worker thread. Supplying a value of
+        /// 0 means 4 loads per worker thread.</param>
+        [DllImport("stbi")]
+        public static extern void ConfigureAsyncPool(int numThreads, int queueCapacity);
+
+        /// <summary>
+        /// The number of loads that can be running or queued on the native worker pool before
+        /// <see cref="LoadAsync(byte*, long, StbiLoadOptions*, int*, IntPtr, IntPtr)"/> blocks.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern long AsyncPoolCapacity();
+
+        /// <summary>
+        /// The number of loads that can be queued on the native worker pool before
+        /// <see cref="LoadAsync(byte*, long, StbiLoadOptions*, int*, IntPtr, IntPtr)"/> blocks. A worker thread
+        /// only takes the next load off the queue once the callback of its current load has returned, so callers
+        /// that count a load as in flight until its callback is invoked have to stay within this number, rather
+        /// than <see cref="AsyncPoolCapacity"/>, to never block.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern long AsyncPoolQueueCapacity();
+
+        /// <summary>
+        /// Queues the load of an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats) residing at
+        /// <paramref name="data"/> on the native worker pool. Returns right away, unless the queue is full, in which
+        /// case it blocks until a worker thread frees a slot.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data. Must stay valid until the
+        /// callback was invoked.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="options">Options that only affect this load. Must stay valid until the callback was invoked.</param>
+        /// <param name="cancelled">Pointer to a flag that cancels the load when it is set to nonzero, or null.
+        /// Must stay valid until the callback was invoked. The flag is checked before the load starts, whenever
+        /// STBI consumes another chunk of the encoded data, and before post-processing. Loads with a flag are
+        /// decoded serially, regardless of <see cref="StbiLoadOptions.NumThreads"/>.</param>
+        /// <param name="callback">Pointer to a <see cref="StbiLoadCallback"/> that receives the outcome of the load.</param>
+        /// <param name="user">Passed to the callback.</param>
+        /// <returns>True if the load was queued.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadAsync(byte* data, long len, StbiLoadOptions* options, int* cancelled, IntPtr callback, IntPtr user);
+
+        private static readonly object asyncLock = new object();
+        private static SemaphoreSlim asyncSlots = null;
+
+        // Loads wait for a slot here rather than blocking a thread in the native queue. A load holds its slot
+        // until its callback runs, so there are never more loads queued than there are slots.
+        private static SemaphoreSlim AsyncSlots
+        {
+            get
+            {
+                lock (asyncLock)
+                {
+                    if (asyncSlots == null)
+                        asyncSlots = new SemaphoreSlim((int)Math.Min(AsyncPoolQueueCapacity(), int.MaxValue));
+
+                    return asyncSlots;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Replaces the pool of native worker threads on which <see cref="LoadAsync(ReadOnlyMemory{byte}, StbiLoadOptions, CancellationToken)"/>
+        /// decodes. Returns without waiting for the previous pool, on which loads that are already queued still
+        /// complete. May be called from the completion of a load.
+        /// </summary>
+        /// <param name="numThreads">The number of worker threads. Supplying a value of 0 means that one thread per
+        /// hardware thread is used.</param>
+        /// <param name="queueCapacity">The number of loads that can wait for a worker thread. Supplying a value of
+        /// 0 means 4 loads per worker thread. This is also the number of managed loads that are in flight at
+        /// once, so it should be at least <paramref name="numThreads"/>.</param>
+        public static void ConfigureAsync(int numThreads, int queueCapacity)
+        {
+            lock (asyncLock)
+            {
+                ConfigureAsyncPool(numThreads, queueCapacity);
+                asyncSlots = new SemaphoreSlim((int)Math.Min(AsyncPoolQueueCapacity(), int.MaxValue));
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> on a pool of native worker threads. At most
+        /// <see cref="AsyncPoolQueueCapacity"/> loads are in flight at once; further loads wait asynchronously
+        /// for one of them to complete, without blocking a thread. The queue capacity should therefore be at
+        /// least the number of worker threads, as it is by default, to keep all of them busy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded. It is pinned until the load completes.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <param name="cancellationToken">Cancels the load while it waits for a slot, waits for a worker thread,
+        /// or consumes the encoded data. Once the data is consumed, the load completes regardless. Loads that can
+        /// be cancelled check it while they consume the data, so they are decoded serially, regardless of
+        /// <see cref="StbiLoadOptions.NumThreads"/>.</param>
+        /// <returns>Returns a task of a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data. The task faults with an <see cref="ArgumentException"/>
+        /// when image loading fails.</returns>
+        /// <exception cref="ArgumentException">Thrown when <paramref name="options"/> requests a bit depth other than 8.</exception>
+        public static Task<StbiImage> LoadAsync(ReadOnlyMemory<byte> data, StbiLoadOptions options, CancellationToken cancellationToken = default)
+        {
+            if (options.BitsPerChannel != 0 && options.BitsPerChannel != 8)
+                throw new ArgumentException($"Only 8 bits per channel can be loaded into a StbiImage. Use {nameof(Load16FromMemory)} or {nameof(LoadFFromMemory)} for other bit depths.", nameof(options));
+
+            return LoadAsyncCore(data, options, cancellationToken);
+        }
+
+        private static async Task<StbiImage> LoadAsyncCore(ReadOnlyMemory<byte> data, StbiLoadOptions options, CancellationToken cancellationToken)
+        {
+            var slots = AsyncSlots;
+            await slots.WaitAsync(cancellationToken).ConfigureAwait(false);
+
+            var load = new StbiAsyncLoad(slots, cancellationToken);
+            load.Start(data, options);
+            return await load.Task.ConfigureAwait(false);
+        }
+
+        /// <summary>
+        /// Flip the image vertically, so the first pixel in the output array is the bottom left. This setting
+        /// is global and affects loads on all threads. Use <see cref="StbiLoadOptions.FlipVertically"/> to flip
+        /// individual loads instead.
+        /// </summary>
+        /// <param name="shouldFlip">True if should flip vertically on load.</param>
+        [DllImport("stbi")]
+        unsafe public static extern void SetFlipVerticallyOnLoad(bool shouldFlip);
+
+        /// <summary>
+        /// Frees memory of an image that has previously been loaded by <see cref="LoadFromMemory"/>. Only
+        /// has to be called when the byte-pointer overload of <see cref="LoadFromMemory"/> was used.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the pixel data.</param>
+        [DllImport("stbi")]
+        unsafe public static extern void Free(byte* data);
+
+        /// <summary>
+        /// Replaces the host allocator from which STBI obtains memory, which by default is malloc and free.
+        /// Memory that decoders free is held on to in per-thread arenas and reused by subsequent loads, so that
+        /// the host allocator is only involved when an arena runs dry. Memory is always returned to the host
+        /// allocator that it was obtained from, so a replaced allocator must keep accepting frees as long as images
+        /// or arenas hold memory from it. Passing null pointers restores malloc and free.
+        /// </summary>
+        /// <param name="malloc">Pointer to a <see cref="StbiMallocCallback"/>.</param>
+        /// <param name="free">Pointer to a <see cref="StbiFreeCallback"/>.</param>
+        /// <param name="user">Opaque pointer that is passed to <paramref name="malloc"/> and <paramref name="free"/>.</param>
+        [DllImport("stbi")]
+        public static extern void SetAllocator(IntPtr malloc, IntPtr free, IntPtr user);
+
+        /// <summary>
+        /// Sets the maximum number of freed bytes that the arena of each thread holds on to for reuse by subsequent
+        /// loads. Memory beyond that is returned to the host allocator. Defaults to 16 MiB. An arena lives as long
+        /// as its thread. <see cref="LoadBatch(StbiBatchItem*, long, int)"/> and
+        /// <see cref="InfoBatch(StbiInfoItem*, long, int)"/> run on threads that persist across calls, so their
+        /// arenas are reused by subsequent batches.
+        /// </summary>
+        /// <param name="numBytes">The capacity of each thread's arena in bytes.</param>
+        [DllImport("stbi")]
+        public static extern void SetArenaCapacity(long numBytes);
+
+        /// <summary>
+        /// Retrieves statistics of STBI's allocator, which help to size <see cref="SetArenaCapacity"/>.
+        /// </summary>
+        /// <param name="stats">The statistics, aggregated over all threads.</param>
+        [DllImport("stbi")]
+        public static extern void GetAllocatorStats(out StbiAllocatorStats stats);
+
+        /// <summary>
+        /// Enables or disables the collection of decode statistics, which are off by default, such that decodes do not
+        /// pay for reading the clock and for the additional header parse that breaks out header time. Enabling
+        /// <see cref="StbiEventSource"/> enables them, too.
+        /// </summary>
+        /// <param name="enabled">True to collect statistics.</param>
+        [DllImport("stbi")]
+        public static extern void SetStatsEnabled(bool enabled);
+
+        /// <summary>
+        /// Retrieves decode statistics, aggregated over all threads since they were last reset.
+        /// </summary>
+        /// <param name="formats">Pointer to an array that receives the statistics of each format, indexed by <see cref="StbiFormat"/>.</param>
+        /// <param name="numFormats">The number of elements of <paramref name="formats"/>.</param>
+        /// <param name="peakLiveBytes">The highest number of bytes that STBI had allocated at the same time.</param>
+        [DllImport("stbi")]
+        unsafe public static extern void GetStats(StbiFormatStats* formats, int numFormats, out long peakLiveBytes);
+
+        /// <summary>
+        /// Retrieves decode statistics, aggregated over all threads since they were last reset. Statistics are only
+        /// collected while enabled through <see cref="SetStatsEnabled(bool)"/> or <see cref="StbiEventSource"/>.
+        /// </summary>
+        /// <returns>A snapshot of the statistics.</returns>
+        unsafe public static StbiStats GetStats()
+        {
+            var formats = new StbiFormatStats[(int)StbiFormat.Other + 1];
+            long peakLiveBytes;
+            fixed (StbiFormatStats* address = formats)
+                GetStats(address, formats.Length, out peakLiveBytes);
+
+            return new StbiStats(formats, peakLiveBytes);
+        }
+
+        /// <summary>
+        /// Resets all decode statistics to zero, and the peak number of allocated bytes to the current number.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern void ResetStats();
+
+        /// <summary>
+        /// After failure to load an image, returns a pointer to a string describing the reason for the failure.
+        /// The reason is tracked per thread and refers to the last call on the calling thread. Returns null if
+        /// that call succeeded.
+        /// </summary>
+        [DllImport("stbi", EntryPoint = "FailureReason")]
+        unsafe public static extern IntPtr FailureReasonIntPtr();
+
+        /// <summary>
+        /// After failure to load an image, returns a string describing the reason for the failure.
+        /// The reason is tracked per thread and refers to the last call on the calling thread. Returns null if
+        /// that call succeeded.
+        /// </summary>
+        public static string FailureReason() => Marshal.PtrToStringAnsi(FailureReasonIntPtr());
+
+        /// <summary>
+        /// Returns the outcome of the last call on the calling thread. Unlike <see cref="FailureReason"/>,
+        /// this does not allocate.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern StbiError LastError();
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> and passes it to <paramref name="callback"/> in bands of
+        /// <paramref name="numRowsPerCall"/> rows. Non-interlaced PNGs are decoded band by band, such that memory
+        /// scales with their width rather than their area. All other images, including interlaced PNGs and PNGs
+        /// that are flipped on load, are decoded in their entirety first, so they take as much memory as
+        /// <see cref="LoadFromMemory(byte*, long, out int, out int, out int, int)"/>; only their delivery is split into bands.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="numRowsPerCall">The maximum number of rows per call of <paramref name="callback"/>.</param>
+        /// <param name="callback">Pointer to a <see cref="StbiRowCallback"/>.</param>
+        /// <param name="user">Passed to <paramref name="callback"/>.</param>
+        /// <returns>True on success, false on failure. Stopping early through the callback counts as success.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadRowsFromMemory(byte* data, long len, int desiredNumChannels, int numRowsPerCall, IntPtr callback, IntPtr user);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> and passes it to <paramref name="sink"/> in bands of
+        /// <paramref name="numRowsPerCall"/> rows. Non-interlaced PNGs are decoded band by band, such that memory
+        /// scales with their width rather than their area. All other images, including interlaced PNGs and PNGs
+        /// that are flipped on load, are decoded in their entirety first, so they take as much memory as
+        /// <see cref="LoadFromMemory(ReadOnlySpan{byte}, int)"/>; only their delivery is split into bands.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="sink">Receives the rows of the image.</param>
+        /// <param name="numRowsPerCall">The maximum number of rows per call of <see cref="IStbiRowSink.WriteRows"/>.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadRowsFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels, IStbiRowSink sink, int numRowsPerCall)
+        {
+            var adapter = new StbiRowSinkAdapter(sink);
+            var handle = GCHandle.Alloc(adapter);
+            try
+            {
+                bool success;
+                fixed (byte* address = data)
+                    success = LoadRowsFromMemory(address, data.Length, desiredNumChannels, numRowsPerCall, StbiRowSinkAdapter.Callback, GCHandle.ToIntPtr(handle));
+
+                adapter.ThrowIfFailed();
+                if (!success)
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Opens an animated GIF residing at <paramref name="data"/>, whose frames can then be decoded one at a
+        /// time by <see cref="NextGifFrame"/>. Only the two most recent frames are kept, which are needed for
+        /// compositing the next one. The data must remain valid until the GIF is closed by <see cref="CloseGif"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="width">The number of pixels the frames are wide.</param>
+        /// <param name="height">The number of pixels the frames are tall.</param>
+        /// <param name="numChannels">The number of colour channels of the decoded frames.</param>
+        /// <returns>The opened GIF, or null on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern IntPtr OpenGif(byte* data, long len, int desiredNumChannels, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Decodes the next frame of a GIF that was opened by <see cref="OpenGif"/> into <paramref name="dst"/>,
+        /// which must hold width * height * numChannels bytes.
+        /// </summary>
+        /// <returns>1 if a frame was decoded, 0 at the end of the animation, and -1 on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern int NextGifFrame(IntPtr gif, byte* dst, out int delayMilliseconds);
+
+        /// <summary>
+        /// Closes a GIF that was opened by <see cref="OpenGif"/>.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern void CloseGif(IntPtr gif);
+
+        /// <summary>
+        /// Lazily decodes the frames of an animated GIF residing at <paramref name="data"/>. Frames are decoded
+        /// as they are enumerated, and only the two most recent ones are kept natively, so memory use does not
+        /// depend on the length of the animation and enumeration can stop at any point.
+        /// </summary>
+        /// <param name="data">The encoded image data. It is pinned while the frames are being enumerated.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>The frames. Each one has a buffer of its own.</returns>
+        /// <exception cref="ArgumentException">Thrown during enumeration when decoding fails.</exception>
+        public static IEnumerable<StbiFrame> LoadGifFramesFromMemory(ReadOnlyMemory<byte> data, int desiredNumChannels)
+        {
+            using (var pin = data.Pin())
+            {
+                IntPtr gif = OpenPinnedGif(pin, data.Length, desiredNumChannels, out int width, out int height, out int numChannels);
+                if (gif == IntPtr.Zero)
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+
+                try
+                {
+                    for (int index = 0; ; ++index)
+                    {
+                        var pixels = new byte[width * height * numChannels];
+                        int result = NextGifFrameInto(gif, pixels, out int delay);
+                        if (result == 0)
+                            yield break;
+                        else if (result < 0)
+                            throw new ArgumentException($"STBI could not load frame {index} from the provided {nameof(data)}: {FailureReason()}");
+
+                        yield return new StbiFrame(index, width, height, numChannels, delay, pixels);
+                    }
+                }
+                finally
+                {
+                    CloseGif(gif);
+                }
+            }
+        }
+
+        // Unsafe code may not appear in iterators, so pointers are handled by these helpers.
+        unsafe private static IntPtr OpenPinnedGif(MemoryHandle pin, int len, int desiredNumChannels, out int width, out int height, out int numChannels) =>
+            OpenGif((byte*)pin.Pointer, len, desiredNumChannels, out width, out height, out numChannels);
+
+        unsafe private static int NextGifFrameInto(IntPtr gif, byte[] dst, out int delayMilliseconds)
+        {
+            fixed (byte* address = dst)
+                return NextGifFrame(gif, address, out delayMilliseconds);
+        }
+
+        /// <summary>
+        /// Creates a decoder for an image whose encoded data arrives piece by piece. See <see cref="StbiDecoder"/>.
+        /// The decoder must be destroyed by <see cref="DestroyDecoder"/>.
+        /// </summary>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>The decoder, or null on failure.</returns>
+        [DllImport("stbi")]
+        public static extern IntPtr CreateDecoder(int desiredNumChannels);
+
+        /// <summary>
+        /// Appends <paramref name="len"/> bytes of encoded data to a decoder, which copies them.
+        /// </summary>
+        [DllImport("stbi")]
+        unsafe public static extern StbiDecoderState FeedDecoder(IntPtr decoder, byte* data, long len);
+
+        /// <summary>
+        /// Signals a decoder that all data has been fed, such that images whose end cannot be detected are decoded.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern StbiDecoderState FinishDecoder(IntPtr decoder);
+
+        /// <summary>
+        /// Retrieves the dimensions and number of colour channels of the image of a decoder. Returns false if
+        /// its header has not arrived yet.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern bool DecoderInfo(IntPtr decoder, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Returns a pointer to the rows of pixels that a decoder has decoded so far, and their number.
+        /// The pixels are owned by the decoder.
+        /// </summary>
+        [DllImport("stbi")]
+        unsafe public static extern byte* DecoderRows(IntPtr decoder, out int numRows);
+
+        /// <summary>
+        /// Destroys a decoder that was created by <see cref="CreateDecoder"/>, including its pixels.
+        /// </summary>
+        [DllImport("stbi")]
+        public static extern void DestroyDecoder(IntPtr decoder);
+
+        [DllImport("stbi", EntryPoint = "ActiveKernels")]
+        private static extern IntPtr ActiveKernelsIntPtr();
+
+        /// <summary>
+        /// Returns a description of the SIMD kernels that STBI uses on this CPU, for example
+        /// <c>"jpeg: sse2, channels: avx2"</c>. <c>jpeg</c> refers to stb_image's IDCT and YCbCr conversion,
+        /// <c>channels</c> to channel reordering and alpha premultiplication (see <see cref="StbiLoadOptions"/>).
+        /// Each is one of <c>avx2</c>, <c>sse2</c>, <c>neon</c>, or <c>scalar</c>.
+        /// </summary>
+        public static string ActiveKernels() => Marshal.PtrToStringAnsi(ActiveKernelsIntPtr());
+
+        /// <summary>
+        /// Attempts to load an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Neither throws nor allocates on failure, which makes
+        /// it suitable for inputs that are frequently corrupt.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="image">On success, a disposable <see cref="StbiImage"/> object that exposes
+        /// image data and metadata. Null on failure.</param>
+        /// <param name="error"><see cref="StbiError.Ok"/> on success, otherwise the reason for the failure.</param>
+        /// <returns>True on success, false on failure.</returns>
+        unsafe public static bool TryLoadFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels, out StbiImage image, out StbiError error)
+        {
+            fixed (byte* address = data)
+            {
+                byte* pixels = LoadFromMemory(address, data.Length, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    image = null;
+                    error = LastError();
+                    return false;
+                }
+
+                image = new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+                error = StbiError.Ok;
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Attempts to retrieve metadata from an encoded image (in PNG, JPG, or another supported format; see the
+        /// README of https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>. Neither throws nor allocates on failure.
+        /// </summary>
+        /// <param name="data">The encoded image data.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="error"><see cref="StbiError.Ok"/> on success, otherwise the reason for the failure.</param>
+        /// <returns>True on success, false on failure.</returns>
+        unsafe public static bool TryInfoFromMemory(ReadOnlySpan<byte> data, out int width, out int height, out int numChannels, out StbiError error)
+        {
+            fixed (byte* address = data)
+            {
+                bool success = InfoFromMemory(address, data.Length, out width, out height, out numChannels);
+                error = success ? StbiError.Ok : LastError();
+                return success;
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        unsafe public static StbiImage LoadFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels)
+        {
+            fixed (byte* address = data)
+            {
+                byte* pixels = LoadFromMemory(address, data.Length, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        public static StbiImage LoadFromMemory(MemoryStream data, int desiredNumChannels)
+            => LoadFromMemory(WrittenData(data), desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="options">Options that only affect this load.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N channels ordered RGBA, where each channel has
+        /// <see cref="StbiLoadOptions.BitsPerChannel"/> bits.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern void* LoadFromMemoryWithOptions(byte* data, long len, ref StbiLoadOptions options, out int width, out int height, out int numChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// must be 0 or 8.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage LoadFromMemory(ReadOnlySpan<byte> data, StbiLoadOptions options)
+        {
+            if (options.BitsPerChannel != 0 && options.BitsPerChannel != 8)
+                throw new ArgumentException($"Only 8 bits per channel can be loaded into a StbiImage. Use {nameof(Load16FromMemory)} or {nameof(LoadFFromMemory)} for other bit depths.", nameof(options));
+
+            fixed (byte* address = data)
+            {
+                byte* pixels = (byte*)LoadFromMemoryWithOptions(address, data.Length, ref options, out int width, out int height, out int numChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage(pixels, width, height, options.DesiredNumChannels == 0 ? numChannels : options.DesiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="options">Options that only affect this load.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N channels ordered RGBA, where each channel has
+        /// <see cref="StbiLoadOptions.BitsPerChannel"/> bits.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long. Images that do not fit
+        /// fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadFromMemoryIntoBufferWithOptions(byte* data, long len, ref StbiLoadOptions options, void* dst, long dstLen);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>. The image is decoded directly
+        /// into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N channels ordered RGBA, where each channel has <see cref="StbiLoadOptions.BitsPerChannel"/> bits.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadFromMemoryIntoBuffer(ReadOnlySpan<byte> data, StbiLoadOptions options, Span<byte> dst)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadFromMemoryIntoBufferWithOptions(address, data.Length, ref options, dstAddress, dst.Length))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>, whose rows are
+        /// <paramref name="rowStride"/> bytes apart, e.g. to match the row pitch of a GPU staging buffer.
+        /// Every byte of <paramref name="dst"/> is written at most once and never read, such that
+        /// <paramref name="dst"/> may be write-combined memory that is mapped for uploads.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.FlipVertically"/>
+        /// writes the rows bottom-up, which, unlike for other loads, costs no additional pass.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the image is loaded.
+        /// Each row is stored pixel by pixel. Each pixel consists of N channels ordered RGBA, where each channel
+        /// has <see cref="StbiLoadOptions.BitsPerChannel"/> bits. Bytes between the end of a row and the
+        /// beginning of the next row are left untouched.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long.</param>
+        /// <param name="rowStride">Number of bytes from the beginning of one row to the beginning of the next.
+        /// Supplying a value of 0 means that rows are packed.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadFromMemoryIntoStridedBuffer(byte* data, long len, ref StbiLoadOptions options, void* dst, long dstLen, long rowStride);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into <paramref name="dst"/>, whose rows are
+        /// <paramref name="rowStride"/> bytes apart, e.g. to match the row pitch of a GPU staging buffer.
+        /// Every byte of <paramref name="dst"/> is written at most once and never read, such that
+        /// <paramref name="dst"/> may be write-combined memory that is mapped for uploads.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.FlipVertically"/>
+        /// writes the rows bottom-up, which, unlike for other loads, costs no additional pass.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. Each row is stored pixel
+        /// by pixel. Each pixel consists of N channels ordered RGBA, where each channel has
+        /// <see cref="StbiLoadOptions.BitsPerChannel"/> bits. Bytes between the end of a row and the
+        /// beginning of the next row are left untouched.</param>
+        /// <param name="rowStride">Number of bytes from the beginning of one row to the beginning of the next.
+        /// Supplying a value of 0 means that rows are packed.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails, or when <paramref name="dst"/>
+        /// cannot hold the image at <paramref name="rowStride"/>.</exception>
+        unsafe public static void LoadFromMemoryIntoBuffer(ReadOnlySpan<byte> data, StbiLoadOptions options, Span<byte> dst, long rowStride)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+                if (!LoadFromMemoryIntoStridedBuffer(address, data.Length, ref options, dstAddress, dst.Length, rowStride))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with 16 bits per channel.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N 16-bit unsigned integers where N is the number of channels, ordered RGBA.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern ushort* Load16FromMemory(byte* data, long len, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with 16 bits per channel.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage{T}"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage{T}"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage<ushort> Load16FromMemory(ReadOnlySpan<byte> data, int desiredNumChannels)
+        {
+            fixed (byte* address = data)
+            {
+                ushort* pixels = Load16FromMemory(address, data.Length, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage<ushort>(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with 16 bits per channel.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// is ignored.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage{T}"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage{T}"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage<ushort> Load16FromMemory(ReadOnlySpan<byte> data, StbiLoadOptions options)
+        {
+            options.BitsPerChannel = 8 * sizeof(ushort);
+            fixed (byte* address = data)
+            {
+                ushort* pixels = (ushort*)LoadFromMemoryWithOptions(address, data.Length, ref options, out int width, out int height, out int numChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage<ushort>(pixels, width, height, options.DesiredNumChannels == 0 ? numChannels : options.DesiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with 16 bits per channel into <paramref name="dst"/>. The image is decoded
+        /// directly into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N 16-bit unsigned integers where N is the number of channels, ordered RGBA.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long. Images that do not fit
+        /// fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool Load16FromMemoryIntoBuffer(byte* data, long len, int desiredNumChannels, ushort* dst, long dstLen);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with 16 bits per channel into <paramref name="dst"/>. The image is decoded
+        /// directly into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N 16-bit unsigned integers where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void Load16FromMemoryIntoBuffer(ReadOnlySpan<byte> data, int desiredNumChannels, Span<ushort> dst)
+        {
+            fixed (byte* address = data)
+            fixed (ushort* dstAddress = dst)
+                if (!Load16FromMemoryIntoBuffer(address, data.Length, desiredNumChannels, dstAddress, (long)dst.Length * sizeof(ushort)))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with floating point channels.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N floats where N is the number of channels, ordered RGBA.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern float* LoadFFromMemory(byte* data, long len, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with floating point channels.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage{T}"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage{T}"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage<float> LoadFFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels)
+        {
+            fixed (byte* address = data)
+            {
+                float* pixels = LoadFFromMemory(address, data.Length, out int width, out int height, out int numChannels, desiredNumChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage<float>(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with floating point channels.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="options">Options that only affect this load. <see cref="StbiLoadOptions.BitsPerChannel"/>
+        /// is ignored.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage{T}"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage{T}"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage<float> LoadFFromMemory(ReadOnlySpan<byte> data, StbiLoadOptions options)
+        {
+            options.BitsPerChannel = 8 * sizeof(float);
+            fixed (byte* address = data)
+            {
+                float* pixels = (float*)LoadFromMemoryWithOptions(address, data.Length, ref options, out int width, out int height, out int numChannels);
+                if (pixels == null)
+                {
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+                }
+
+                return new StbiImage<float>(pixels, width, height, options.DesiredNumChannels == 0 ? numChannels : options.DesiredNumChannels);
+            }
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with floating point channels into <paramref name="dst"/>. The image is decoded
+        /// directly into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">Pointer to the beginning of the destination buffer into which the
+        /// image is loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N floats where N is the number of channels, ordered RGBA.</param>
+        /// <param name="dstLen">Number of bytes that the destination buffer is long. Images that do not fit
+        /// fail with <see cref="StbiError.InvalidArgument"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool LoadFFromMemoryIntoBuffer(byte* data, long len, int desiredNumChannels, float* dst, long dstLen);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> with floating point channels into <paramref name="dst"/>. The image is decoded
+        /// directly into <paramref name="dst"/> without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="dst">The destination buffer into which the image is loaded. The loaded image
+        /// will be stored in this buffer in row-major format, pixel by pixel. Each pixel consists of
+        /// N floats where N is the number of channels, ordered RGBA.</param>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static void LoadFFromMemoryIntoBuffer(ReadOnlySpan<byte> data, int desiredNumChannels, Span<float> dst)
+        {
+            fixed (byte* address = data)
+            fixed (float* dstAddress = dst)
+                if (!LoadFFromMemoryIntoBuffer(address, data.Length, desiredNumChannels, dstAddress, (long)dst.Length * sizeof(float)))
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(data)}: {FailureReason()}");
+        }
+
+        /// <summary>
+        /// Determines whether an encoded image residing at <paramref name="data"/> is a high dynamic range image,
+        /// which is best loaded by <see cref="LoadFFromMemory(ReadOnlySpan{byte}, int)"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <returns>True if the image is a high dynamic range image, false otherwise.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool IsHdrFromMemory(byte* data, long len);
+
+        /// <summary>
+        /// Determines whether an encoded image residing at <paramref name="data"/> is a high dynamic range image,
+        /// which is best loaded by <see cref="LoadFFromMemory(ReadOnlySpan{byte}, int)"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data.</param>
+        /// <returns>True if the image is a high dynamic range image, false otherwise.</returns>
+        unsafe public static bool IsHdrFromMemory(ReadOnlySpan<byte> data)
+        {
+            fixed (byte* address = data)
+                return IsHdrFromMemory(address, data.Length);
+        }
+
+        /// <summary>
+        /// Determines whether an encoded image residing at <paramref name="data"/> has 16 bits per channel,
+        /// in which case it is best loaded by <see cref="Load16FromMemory(ReadOnlySpan{byte}, int)"/>.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the encoded image data.</param>
+        /// <param name="len">Number of bytes that the encoded image data is long.</param>
+        /// <returns>True if the image has 16 bits per channel, false otherwise.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool Is16BitFromMemory(byte* data, long len);
+
+        /// <summary>
+        /// Determines whether an encoded image residing at <paramref name="data"/> has 16 bits per channel,
+        /// in which case it is best loaded by <see cref="Load16FromMemory(ReadOnlySpan{byte}, int)"/>.
+        /// </summary>
+        /// <param name="data">The encoded image data.</param>
+        /// <returns>True if the image has 16 bits per channel, false otherwise.</returns>
+        unsafe public static bool Is16BitFromMemory(ReadOnlySpan<byte> data)
+        {
+            fixed (byte* address = data)
+                return Is16BitFromMemory(address, data.Length);
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// residing at <paramref name="data"/> into memory rented from <paramref name="pool"/>. The image
+        /// is decoded directly into the rented memory without an intermediate copy.
+        /// </summary>
+        /// <param name="data">The encoded image data to be loaded.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <param name="pool">The pool from which the memory of the image is rented, for example
+        /// <see cref="MemoryPool{T}.Shared"/>, which is backed by <see cref="ArrayPool{T}.Shared"/>.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the loaded image.</param>
+        /// <returns>Returns the rented memory, whose <see cref="IMemoryOwner{T}.Memory"/> is exactly as large
+        /// as the loaded image. The image is stored in row-major format, pixel by pixel. Each pixel consists
+        /// of <paramref name="numChannels"/> bytes ordered RGBA. On disposal, the memory is returned to
+        /// <paramref name="pool"/>.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        public static IMemoryOwner<byte> LoadFromMemory(ReadOnlySpan<byte> data, int desiredNumChannels, MemoryPool<byte> pool, out int width, out int height, out int numChannels)
+        {
+            InfoFromMemory(data, out width, out height, out numChannels);
+            if (desiredNumChannels != 0)
+                numChannels = desiredNumChannels;
+
+            int length = width * height * numChannels;
+            var rental = pool.Rent(length);
+            try
+            {
+                LoadFromMemoryIntoBuffer(data, desiredNumChannels, rental.Memory.Span);
+            }
+            catch
+            {
+                rental.Dispose();
+                throw;
+            }
+
+            return new StbiPooledMemory<byte>(rental, length);
+        }
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// that is provided through <paramref name="callbacks"/>.
+        /// </summary>
+        /// <param name="callbacks">Function pointers through which the encoded image data is read.</param>
+        /// <param name="user">Opaque pointer that is passed to each of the <paramref name="callbacks"/>.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the beginning of the buffer into which the
+        /// image was loaded. The loaded image will be stored in this buffer in row-major format, pixel
+        /// by pixel. Each pixel consists of N bytes where N is the number of channels, ordered RGBA.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* LoadFromCallbacks(ref StbiIoCallbacks callbacks, IntPtr user, out int width, out int height, out int numChannels, int desiredNumChannels);
+
+        /// <summary>
+        /// Loads an encoded image (in PNG, JPG, or another supported format; see the README of
+        /// https://github.com/nothings/stb/blob/master/stb_image.h for a list of supported formats)
+        /// from <paramref name="stream"/>. The encoded image data is read through a small, fixed-size
+        /// buffer rather than being copied into memory in its entirety. After loading, the position
+        /// of <paramref name="stream"/> is unspecified.
+        /// </summary>
+        /// <param name="stream">The stream from which the encoded image data is read.</param>
+        /// <param name="desiredNumChannels">The number of desired colour channels in the output.
+        /// When the encoded image has fewer channels than the desired number of channels,
+        /// then the desired number of channels will be produced automatically. For example,
+        /// when the encoded image is RGB, but 4 channels are requested, then a fully opaque
+        /// alpha channel will be generated. Supplying a value of 0 means that the native number
+        /// of channels of the encoded image is used.</param>
+        /// <returns>Returns a disposable <see cref="StbiImage"/> object that exposes image data
+        /// and metadata. On disposal, <see cref="StbiImage"/> frees any native memory that has
+        /// been allocated to store the image data.</returns>
+        /// <exception cref="ArgumentException">Thrown when image loading fails.</exception>
+        unsafe public static StbiImage LoadFromStream(Stream stream, int desiredNumChannels)
+        {
+            var reader = new StbiStreamReader(stream);
+            var handle = GCHandle.Alloc(reader);
+            try
+            {
+                var callbacks = StbiStreamReader.Callbacks;
+                byte* pixels = LoadFromCallbacks(ref callbacks, GCHandle.ToIntPtr(handle), out int width, out int height, out int numChannels, desiredNumChannels);
+
+                // Decoders such as stb_image's JPEG decoder treat the end of their input as zero bits, so a stream
+                // that failed midway can still yield an image, which must not be mistaken for a successful load.
+                try
+                {
+                    reader.ThrowIfFailed();
+                }
+                catch
+                {
+                    if (pixels != null)
+                        Free(pixels);
+
+                    throw;
+                }
+
+                if (pixels == null)
+                    throw new ArgumentException($"STBI could not load an image from the provided {nameof(stream)}: {FailureReason()}");
+
+                return new StbiImage(pixels, width, height, desiredNumChannels == 0 ? numChannels : desiredNumChannels);
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as PNG and passes the encoded data to <paramref name="callback"/>.
+        /// </summary>
+        /// <param name="pixels">Pointer to the first row of the image. Each pixel consists of N bytes where N
+        /// is the number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="rowStride">The number of bytes from the beginning of one row to the beginning of the
+        /// next. Supplying a value of 0 means that rows are packed.</param>
+        /// <param name="compressionLevel">The zlib compression level, from 1 (fastest) to 9 (smallest). Supplying
+        /// a value of 0 means 8. Values outside of [1, 9] are clamped.</param>
+        /// <param name="callback">Pointer to a <see cref="StbiWriteCallback"/>.</param>
+        /// <param name="user">Passed to <paramref name="callback"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool WritePngToMemory(byte* pixels, int width, int height, int numChannels, long rowStride, int compressionLevel, IntPtr callback, IntPtr user);
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as PNG into <paramref name="writer"/>.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N bytes where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="writer">Receives the encoded image data.</param>
+        /// <param name="rowStride">The number of bytes from the beginning of one row to the beginning of the
+        /// next. Supplying a value of 0 means that rows are packed.</param>
+        /// <param name="compressionLevel">The zlib compression level, from 1 (fastest) to 9 (smallest). Supplying
+        /// a value of 0 means 8. Values outside of [1, 9] are clamped.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WritePngToMemory(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, IBufferWriter<byte> writer, long rowStride = 0, int compressionLevel = 0)
+        {
+            WritePng(pixels, width, height, numChannels, rowStride, compressionLevel, new StbiWriterAdapter(writer));
+        }
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as PNG into <paramref name="stream"/>.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N bytes where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="stream">Receives the encoded image data.</param>
+        /// <param name="rowStride">The number of bytes from the beginning of one row to the beginning of the
+        /// next. Supplying a value of 0 means that rows are packed.</param>
+        /// <param name="compressionLevel">The zlib compression level, from 1 (fastest) to 9 (smallest). Supplying
+        /// a value of 0 means 8. Values outside of [1, 9] are clamped.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WritePngToStream(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, Stream stream, long rowStride = 0, int compressionLevel = 0)
+        {
+            WritePng(pixels, width, height, numChannels, rowStride, compressionLevel, new StbiWriterAdapter(stream));
+        }
+
+        unsafe private static void WritePng(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, long rowStride, int compressionLevel, StbiWriterAdapter adapter)
+        {
+            long stride = rowStride == 0 ? (long)width * numChannels : rowStride;
+            if (height > 0 && pixels.Length < (height - 1) * stride + (long)width * numChannels)
+                throw new ArgumentException($"The provided {nameof(pixels)} are too small for an image of size {width}x{height}x{numChannels}.");
+
+            var handle = GCHandle.Alloc(adapter);
+            try
+            {
+                bool success;
+                fixed (byte* address = pixels)
+                    success = WritePngToMemory(address, width, height, numChannels, rowStride, compressionLevel, StbiWriterAdapter.Callback, GCHandle.ToIntPtr(handle));
+
+                adapter.ThrowIfFailed();
+                if (!success)
+                    throw new ArgumentException($"STBI could not encode the provided {nameof(pixels)}: {FailureReason()}");
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as baseline JPEG and passes the encoded data to
+        /// <paramref name="callback"/>. Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">Pointer to the image in row-major order. Each pixel consists of N bytes where N
+        /// is the number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="quality">The quality of the JPEG, from 1 to 100. Supplying a value of 0 means 90.</param>
+        /// <param name="callback">Pointer to a <see cref="StbiWriteCallback"/>.</param>
+        /// <param name="user">Passed to <paramref name="callback"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool WriteJpgToMemory(byte* pixels, int width, int height, int numChannels, int quality, IntPtr callback, IntPtr user);
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as baseline JPEG into <paramref name="writer"/>. Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N bytes where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="quality">The quality of the JPEG, from 1 to 100.</param>
+        /// <param name="writer">Receives the encoded image data.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WriteJpgToMemory(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, int quality, IBufferWriter<byte> writer)
+        {
+            WriteJpg(pixels, width, height, numChannels, quality, new StbiWriterAdapter(writer));
+        }
+
+        /// <summary>
+        /// Encodes an image with 8 bits per channel as baseline JPEG into <paramref name="stream"/>. Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N bytes where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="quality">The quality of the JPEG, from 1 to 100.</param>
+        /// <param name="stream">Receives the encoded image data.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WriteJpgToStream(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, int quality, Stream stream)
+        {
+            WriteJpg(pixels, width, height, numChannels, quality, new StbiWriterAdapter(stream));
+        }
+
+        unsafe private static void WriteJpg(ReadOnlySpan<byte> pixels, int width, int height, int numChannels, int quality, StbiWriterAdapter adapter)
+        {
+            if (pixels.Length < (long)width * height * numChannels)
+                throw new ArgumentException($"The provided {nameof(pixels)} are too small for an image of size {width}x{height}x{numChannels}.");
+
+            var handle = GCHandle.Alloc(adapter);
+            try
+            {
+                bool success;
+                fixed (byte* address = pixels)
+                    success = WriteJpgToMemory(address, width, height, numChannels, quality, StbiWriterAdapter.Callback, GCHandle.ToIntPtr(handle));
+
+                adapter.ThrowIfFailed();
+                if (!success)
+                    throw new ArgumentException($"STBI could not encode the provided {nameof(pixels)}: {FailureReason()}");
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Encodes an image with float channels in linear light as Radiance HDR and passes the encoded data to
+        /// <paramref name="callback"/>. Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">Pointer to the image in row-major order. Each pixel consists of N floats where N
+        /// is the number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="callback">Pointer to a <see cref="StbiWriteCallback"/>.</param>
+        /// <param name="user">Passed to <paramref name="callback"/>.</param>
+        /// <returns>True on success, false on failure.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool WriteHdrToMemory(float* pixels, int width, int height, int numChannels, IntPtr callback, IntPtr user);
+
+        /// <summary>
+        /// Encodes an image with float channels in linear light as Radiance HDR into <paramref name="writer"/>.
+        /// Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N floats where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="writer">Receives the encoded image data.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WriteHdrToMemory(ReadOnlySpan<float> pixels, int width, int height, int numChannels, IBufferWriter<byte> writer)
+        {
+            WriteHdr(pixels, width, height, numChannels, new StbiWriterAdapter(writer));
+        }
+
+        /// <summary>
+        /// Encodes an image with float channels in linear light as Radiance HDR into <paramref name="stream"/>.
+        /// Alpha is ignored.
+        /// </summary>
+        /// <param name="pixels">The image in row-major order. Each pixel consists of N floats where N is the
+        /// number of channels, ordered RGBA.</param>
+        /// <param name="width">The number of pixels the image is wide.</param>
+        /// <param name="height">The number of pixels the image is tall.</param>
+        /// <param name="numChannels">The number of colour channels of the image, from 1 to 4.</param>
+        /// <param name="stream">Receives the encoded image data.</param>
+        /// <exception cref="ArgumentException">Thrown when image encoding fails, or when <paramref name="pixels"/> is too small.</exception>
+        public static void WriteHdrToStream(ReadOnlySpan<float> pixels, int width, int height, int numChannels, Stream stream)
+        {
+            WriteHdr(pixels, width, height, numChannels, new StbiWriterAdapter(stream));
+        }
+
+        unsafe private static void WriteHdr(ReadOnlySpan<float> pixels, int width, int height, int numChannels, StbiWriterAdapter adapter)
+        {
+            if (pixels.Length < (long)width * height * numChannels)
+                throw new ArgumentException($"The provided {nameof(pixels)} are too small for an image of size {width}x{height}x{numChannels}.");
+
+            var handle = GCHandle.Alloc(adapter);
+            try
+            {
+                bool success;
+                fixed (float* address = pixels)
+                    success = WriteHdrToMemory(address, width, height, numChannels, StbiWriterAdapter.Callback, GCHandle.ToIntPtr(handle));
+
+                adapter.ThrowIfFailed();
+                if (!success)
+                    throw new ArgumentException($"STBI could not encode the provided {nameof(pixels)}: {FailureReason()}");
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Inflates a zlib stream, or a raw deflate stream, residing at <paramref name="data"/> into
+        /// <paramref name="dst"/>. Uses libdeflate if the native library was built with it, and the
+        /// inflate of stb_image otherwise.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the compressed data.</param>
+        /// <param name="len">Number of bytes that the compressed data is long.</param>
+        /// <param name="dst">Pointer to the buffer into which the data is inflated.</param>
+        /// <param name="dstLen">Number of bytes that <paramref name="dst"/> is long.</param>
+        /// <param name="parseHeader">True for zlib streams, false for raw deflate streams.</param>
+        /// <param name="outLen">The number of inflated bytes.</param>
+        /// <returns>True on success, false on failure, including when <paramref name="dst"/> is too small.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern bool ZlibDecode(byte* data, long len, byte* dst, long dstLen, bool parseHeader, out long outLen);
+
+        /// <summary>
+        /// Inflates a zlib stream, or a raw deflate stream, into <paramref name="dst"/>.
+        /// </summary>
+        /// <param name="data">The compressed data.</param>
+        /// <param name="dst">The buffer into which the data is inflated.</param>
+        /// <param name="parseHeader">True for zlib streams, false for raw deflate streams.</param>
+        /// <returns>The number of inflated bytes.</returns>
+        /// <exception cref="ArgumentException">Thrown when the data is corrupt, or when <paramref name="dst"/> is too small.</exception>
+        unsafe public static int ZlibDecode(ReadOnlySpan<byte> data, Span<byte> dst, bool parseHeader = true)
+        {
+            fixed (byte* address = data)
+            fixed (byte* dstAddress = dst)
+            {
+                if (!ZlibDecode(address, data.Length, dstAddress, dst.Length, parseHeader, out long outLen))
+                    throw new ArgumentException($"STBI could not inflate the provided {nameof(data)}: {FailureReason()}");
+
+                return (int)outLen;
+            }
+        }
+
+        /// <summary>
+        /// Like <see cref="ZlibDecode(byte*, long, byte*, long, bool, out long)"/>, but inflates into a buffer that
+        /// grows until the data fits.
+        /// </summary>
+        /// <param name="data">Pointer to the beginning of the compressed data.</param>
+        /// <param name="len">Number of bytes that the compressed data is long.</param>
+        /// <param name="initialSize">The expected number of inflated bytes, or 0 if unknown.</param>
+        /// <param name="parseHeader">True for zlib streams, false for raw deflate streams.</param>
+        /// <param name="outLen">The number of inflated bytes.</param>
+        /// <returns>Null on failure. On success, returns a pointer to the inflated data, which has to be
+        /// released by <see cref="Free(byte*)"/>.</returns>
+        [DllImport("stbi")]
+        unsafe public static extern byte* ZlibDecodeMalloc(byte* data, long len, long initialSize, bool parseHeader, out long outLen);
+
+        /// <summary>
+        /// Inflates a zlib stream, or a raw deflate stream, into a new array.
+        /// </summary>
+        /// <param name="data">The compressed data.</param>
+        /// <param name="initialSize">The expected number of inflated bytes, or 0 if unknown.</param>
+        /// <param name="parseHeader">True for zlib streams, false for raw deflate streams.</param>
+        /// <returns>The inflated data.</returns>
+        /// <exception cref="ArgumentException">Thrown when the data is corrupt.</exception>
+        unsafe public static byte[] ZlibDecode(ReadOnlySpan<byte> data, long initialSize = 0, bool parseHeader = true)
+        {
+            byte* inflated;
+            long outLen;
+            fixed (byte* address = data)
+                inflated = ZlibDecodeMalloc(address, data.Length, initialSize, parseHeader, out outLen);
+
+            if (inflated == null)
+                throw new ArgumentException($"STBI could not inflate the provided {nameof(data)}: {FailureReason()}");
+
+            try
+            {
+                return new ReadOnlySpan<byte>(inflated, checked((int)outLen)).ToArray();
+            }
+            finally
+            {
+                Free(inflated);
+            }
+        }
+    }
+}